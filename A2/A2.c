@@ -2,15 +2,24 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include <limits.h>
+#include <pthread.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
 
 static void die_perror(const char *msg)
 {
@@ -25,11 +34,16 @@ static void usage(const char *prog)
             "  %s root_process process_id [Option]\n"
             "  %s -bcp\n"
             "  %s -bop\n"
+            "  %s -daemon [poll_seconds]   (queries on stdin: root_process process_id [-cnt|-oct|-dnd])\n"
+            "  %s -batch [-cnt,-oct,...]   (read-only options; queries on stdin: root_process process_id)\n"
             "Options:\n"
             "  -cnt -oct -dtm -odt -ndt -dnd -sst -sco\n"
             "  -kgp -kpp -ksp -kps -kgc -kcp -krp\n"
-            "  -mmd -mpd\n",
-            prog, prog, prog);
+            "  -mmd -mpd\n"
+            "  -watch <interval_seconds> [lines]\n"
+            "Global options (may appear anywhere):\n"
+            "  --threads N   scan /proc with N threads (0 = one per CPU, default 1)\n",
+            prog, prog, prog, prog, prog);
 }
 
 /* 用途：保存单个进程从 /proc 读取到的核心信息。 */
@@ -42,7 +56,7 @@ typedef struct Proc
     long stime_ticks;      /* clock ticks */
     long long start_ticks; /* starttime in clock ticks since boot */
     long long vmrss_bytes; /* VmRSS in bytes, -1 if unknown */
-    char name[64];         /* process name, from status Name: */
+    char name[64];         /* process name, comm field of stat */
     int is_bash;           /* 1 if bash, else 0 */
 } Proc;
 
@@ -52,44 +66,132 @@ typedef struct ProcList
     size_t count;
 } ProcList;
 
+/* /proc/<pid>/stat 一行通常远小于 1 KiB；comm 最长 16 字节，4 KiB 足够容纳 */
+#define PROC_READ_BUF_SIZE 4096
+
+/* 每个扫描线程一份的读缓冲区，热路径上不做任何堆分配 */
+static __thread char proc_read_buf[PROC_READ_BUF_SIZE];
+
 /**
- * 用途：读取 /proc/<pid>/stat 中的 PPid 字段，保存在 ppid_out 中。
+ * 用途：用 open + pread 把一个小文件（/proc 下的 stat、statm 等）一次读入 buf，并在末尾补 '\0'。
+ * 返回读到的字节数；失败返回 -1。
  */
-static int read_ppid_from_proc(pid_t pid, pid_t *ppid_out)
+static ssize_t read_small_file(const char *path, char *buf, size_t size)
 {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
 
-    FILE *fp = fopen(path, "r");
-    if (!fp)
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    close(fd);
+    if (n < 0)
         return -1;
 
-    char line[256];
-    while (fgets(line, sizeof(line), fp))
+    buf[n] = '\0';
+    return n;
+}
+
+/**
+ * 用途：从 p 开始解析一个十进制整数（可带负号），不经过 strtol，返回整数之后的位置。
+ */
+static const char *scan_decimal(const char *p, const char *end, long long *value_out)
+{
+    int negative = 0;
+    long long value = 0;
+
+    if (p < end && *p == '-')
     {
-        if (strncmp(line, "PPid:", 5) == 0)
-        {
-            char *p = line + 5;
-            while (*p && isspace((unsigned char)*p))
-                p++;
+        negative = 1;
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
 
-            long ppid_val = strtol(p, NULL, 10);
-            fclose(fp);
+    *value_out = negative ? -value : value;
+    return p;
+}
 
-            if (ppid_val < 0 || ppid_val > INT_MAX)
-                return -1;
+/**
+ * 用途：解析 /proc/<pid>/stat 的一行内容，填充 proc_out 中的 name、state、ppid、utime、stime、starttime。
+ * 实现思路：
+ * 1. comm 取第一个 '(' 与最后一个 ')' 之间的内容（comm 本身可能含空格或括号）
+ * 2. 从 ')' 之后向前扫描一次，只解析第 3/4/14/15/22 个字段，其它字段直接跳过
+ */
+static int parse_proc_stat(const char *buf, size_t len, Proc *proc_out)
+{
+    const char *end = buf + len;
+    const char *left_paren = memchr(buf, '(', len);
+    const char *right_paren = memrchr(buf, ')', len);
+    if (!left_paren || !right_paren || right_paren < left_paren || right_paren + 2 >= end || right_paren[1] != ' ')
+        return -1;
 
-            *ppid_out = (pid_t)ppid_val;
-            return 0;
+    size_t name_len = (size_t)(right_paren - left_paren - 1);
+    if (name_len >= sizeof(proc_out->name))
+        name_len = sizeof(proc_out->name) - 1;
+    memcpy(proc_out->name, left_paren + 1, name_len);
+    proc_out->name[name_len] = '\0';
+
+    const char *p = right_paren + 2;
+    proc_out->state = *p;
+
+    int field_no = 3;
+    while (p < end && field_no < 22)
+    {
+        /* 跳到下一个字段 */
+        while (p < end && *p != ' ')
+            p++;
+        while (p < end && *p == ' ')
+            p++;
+        field_no++;
+
+        if (field_no == 4 || field_no == 14 || field_no == 15 || field_no == 22)
+        {
+            long long value = 0;
+            p = scan_decimal(p, end, &value);
+
+            if (field_no == 4)
+                proc_out->ppid = (pid_t)value;
+            else if (field_no == 14)
+                proc_out->utime_ticks = (long)value;
+            else if (field_no == 15)
+                proc_out->stime_ticks = (long)value;
+            else
+                proc_out->start_ticks = value;
         }
     }
 
-    fclose(fp);
-    return -1;
+    return (field_no == 22) ? 0 : -1;
+}
+
+/**
+ * 用途：解析 /proc/<pid>/statm，返回 RSS 字节数（resident 页数 × 页大小）；没有用户地址空间时返回 -1。
+ */
+static long long parse_proc_statm(const char *buf, size_t len)
+{
+    const char *p = buf;
+    const char *end = buf + len;
+    long long size_pages = 0;
+    long long resident_pages = 0;
+
+    p = scan_decimal(p, end, &size_pages);
+    while (p < end && *p == ' ')
+        p++;
+    scan_decimal(p, end, &resident_pages);
+
+    if (size_pages <= 0 || resident_pages < 0)
+        return -1;
+    return resident_pages * (long long)sysconf(_SC_PAGESIZE);
 }
 
 /**
- * 用途：读取 /proc/<pid>/stat 和 /proc/<pid>/status 中的信息，填充到 proc_out 中。
+ * 用途：读取 /proc/<pid>/stat 和 /proc/<pid>/statm 中的信息，填充到 proc_out 中。
+ * 实现思路：
+ * 1. stat 用 open + pread 读入线程私有缓冲区，一次扫描取出 comm、state、ppid、utime、stime、starttime
+ * 2. RSS 取 statm 的第 2 个字段（resident 页数）乘以页大小，不再读取整个 status 文件
+ * 3. statm 的第 1 个字段为 0 表示没有用户地址空间（内核线程、僵尸进程），与 status 中没有 VmRSS 一样记为 -1
  */
 static int read_proc_info(pid_t pid, Proc *proc_out)
 {
@@ -103,78 +205,21 @@ static int read_proc_info(pid_t pid, Proc *proc_out)
     proc_out->start_ticks = -1;
     proc_out->vmrss_bytes = -1;
 
-    char stat_path[64];
-    snprintf(stat_path, sizeof(stat_path), "/proc/%d/stat", (int)pid);
-
-    FILE *fp = fopen(stat_path, "r");
-    if (!fp)
-        return -1;
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
 
-    char line[4096];
-    if (!fgets(line, sizeof(line), fp))
-    {
-        fclose(fp);
+    ssize_t len = read_small_file(path, proc_read_buf, sizeof(proc_read_buf));
+    if (len <= 0)
         return -1;
-    }
-    fclose(fp);
-
-    char *right_paren = strrchr(line, ')');
-    if (!right_paren || *(right_paren + 1) != ' ')
+    if (parse_proc_stat(proc_read_buf, (size_t)len, proc_out) != 0)
         return -1;
 
-    char *cursor = right_paren + 2;
-    int field_no = 3;
-    char *saveptr = NULL;
-    char *token = strtok_r(cursor, " ", &saveptr);
-
-    while (token)
-    {
-        if (field_no == 3)
-            proc_out->state = token[0];
-        else if (field_no == 4)
-            proc_out->ppid = (pid_t)strtol(token, NULL, 10);
-        else if (field_no == 14)
-            proc_out->utime_ticks = strtol(token, NULL, 10);
-        else if (field_no == 15)
-            proc_out->stime_ticks = strtol(token, NULL, 10);
-        else if (field_no == 22)
-            proc_out->start_ticks = strtoll(token, NULL, 10);
-
-        field_no++;
-        token = strtok_r(NULL, " ", &saveptr);
-    }
-
-    char status_path[64];
-    snprintf(status_path, sizeof(status_path), "/proc/%d/status", (int)pid);
-    fp = fopen(status_path, "r");
-    if (!fp)
-        return 0;
-
-    char status_line[256];
-    while (fgets(status_line, sizeof(status_line), fp))
-    {
-        if (strncmp(status_line, "Name:", 5) == 0)
-        {
-            char *p = status_line + 5;
-            while (*p && isspace((unsigned char)*p))
-                p++;
-            strncpy(proc_out->name, p, sizeof(proc_out->name) - 1);
-            proc_out->name[sizeof(proc_out->name) - 1] = '\0';
-            proc_out->name[strcspn(proc_out->name, "\n")] = '\0';
-        }
-        else if (strncmp(status_line, "VmRSS:", 6) == 0)
-        {
-            char *p = status_line + 6;
-            while (*p && isspace((unsigned char)*p))
-                p++;
-            long long vmrss_kb = strtoll(p, NULL, 10);
-            if (vmrss_kb >= 0)
-                proc_out->vmrss_bytes = vmrss_kb * 1024;
-        }
-    }
-    fclose(fp);
-
     proc_out->is_bash = (strcmp(proc_out->name, "bash") == 0);
+
+    snprintf(path, sizeof(path), "/proc/%d/statm", (int)pid);
+    len = read_small_file(path, proc_read_buf, sizeof(proc_read_buf));
+    if (len > 0)
+        proc_out->vmrss_bytes = parse_proc_statm(proc_read_buf, (size_t)len);
     return 0;
 }
 
@@ -215,13 +260,140 @@ static void free_proc_list(ProcList *list)
     list->count = 0;
 }
 
-static int proc_pid_in_list(pid_t pid, const Proc *list, size_t count)
+/* 用途：pid → 下标 的开放寻址哈希表（线性探测，只支持插入/查找/清空），cap 为 2 的幂，键 0 表示空槽。 */
+typedef struct PidIndex
 {
-    for (size_t i = 0; i < count; i++)
+    pid_t *keys;
+    size_t *values;
+    size_t cap;
+    size_t used;
+} PidIndex;
+
+static size_t pid_hash_slot(pid_t pid, size_t cap)
+{
+    return ((size_t)(unsigned int)pid * 2654435761u) & (cap - 1);
+}
+
+static void pid_index_free(PidIndex *index)
+{
+    free(index->keys);
+    free(index->values);
+    memset(index, 0, sizeof(*index));
+}
+
+static void pid_index_clear(PidIndex *index)
+{
+    if (index->keys)
+        memset(index->keys, 0, index->cap * sizeof(*index->keys));
+    index->used = 0;
+}
+
+/**
+ * 用途：查找 pid 对应的下标；找不到时返回 (size_t)-1。
+ */
+static size_t pid_index_get(const PidIndex *index, pid_t pid)
+{
+    if (index->cap == 0 || pid == 0)
+        return (size_t)-1;
+
+    for (size_t slot = pid_hash_slot(pid, index->cap);; slot = (slot + 1) & (index->cap - 1))
     {
-        if (list[i].pid == pid)
-            return 1;
+        if (index->keys[slot] == pid)
+            return index->values[slot];
+        if (index->keys[slot] == 0)
+            return (size_t)-1;
+    }
+}
+
+/**
+ * 用途：在容量足够的前提下写入 pid → value（不扩容）。
+ */
+static void pid_index_store(PidIndex *index, pid_t pid, size_t value)
+{
+    size_t slot = pid_hash_slot(pid, index->cap);
+    while (index->keys[slot] != 0 && index->keys[slot] != pid)
+        slot = (slot + 1) & (index->cap - 1);
+
+    if (index->keys[slot] == 0)
+        index->used++;
+    index->keys[slot] = pid;
+    index->values[slot] = value;
+}
+
+/**
+ * 用途：保证表中至少能放下 expected 个键且负载因子不超过 1/2，必要时扩容并重新散列。
+ */
+static int pid_index_reserve(PidIndex *index, size_t expected)
+{
+    if (expected * 2 <= index->cap)
+        return 0;
+
+    size_t new_cap = (index->cap == 0) ? 64 : index->cap;
+    while (new_cap < expected * 2)
+        new_cap *= 2;
+
+    PidIndex grown = {0};
+    grown.keys = calloc(new_cap, sizeof(*grown.keys));
+    grown.values = malloc(new_cap * sizeof(*grown.values));
+    if (!grown.keys || !grown.values)
+    {
+        pid_index_free(&grown);
+        return -1;
+    }
+    grown.cap = new_cap;
+
+    for (size_t i = 0; i < index->cap; i++)
+    {
+        if (index->keys[i] != 0)
+            pid_index_store(&grown, index->keys[i], index->values[i]);
+    }
+
+    pid_index_free(index);
+    *index = grown;
+    return 0;
+}
+
+/**
+ * 用途：删除 pid（线性探测的“后移删除”：把后面同一探测链上的键往前挪，不留墓碑）。
+ */
+static void pid_index_remove(PidIndex *index, pid_t pid)
+{
+    if (index->cap == 0 || pid == 0)
+        return;
+
+    size_t mask = index->cap - 1;
+    size_t hole = pid_hash_slot(pid, index->cap);
+    while (index->keys[hole] != pid)
+    {
+        if (index->keys[hole] == 0)
+            return;
+        hole = (hole + 1) & mask;
+    }
+
+    for (size_t next = (hole + 1) & mask; index->keys[next] != 0; next = (next + 1) & mask)
+    {
+        size_t home = pid_hash_slot(index->keys[next], index->cap);
+        if (((next - home) & mask) >= ((next - hole) & mask)) // next 上的键可以挪到 hole
+        {
+            index->keys[hole] = index->keys[next];
+            index->values[hole] = index->values[next];
+            hole = next;
+        }
     }
+
+    index->keys[hole] = 0;
+    index->used--;
+}
+
+/**
+ * 用途：插入或更新 pid → value。
+ */
+static int pid_index_put(PidIndex *index, pid_t pid, size_t value)
+{
+    if (pid == 0 || pid_index_reserve(index, index->used + 1) != 0)
+        return -1;
+
+    pid_index_store(index, pid, value);
     return 0;
 }
 
@@ -256,234 +428,269 @@ static int read_boot_time_epoch(time_t *boot_time_out)
     return -1;
 }
 
-/**
- * 从 /proc 中收集 root_pid 的所有后代进程信息，保存在 descendants_out 中，并将后代数量保存在 descendants_count_out 中。
- * 实现思路：
- * 遍历 /proc 中的每个 pid，对每个 pid 向上追父链，如果在追溯过程中遇到 root_pid 就把这个 pid 的信息加入 descendants_out 中，并且这个 pid 不再继续追父链了
- */
-static int collect_descendants(pid_t root_pid, ProcList *descendants_out)
+/* 用途：一次遍历 /proc 得到的进程快照。procs 按 pid 升序排列，并建立 父进程→子进程 的邻接表和 Euler 序。 */
+typedef struct Snapshot
 {
-    if (!descendants_out)
-        return -1;
+    Proc *procs;         /* 每个 pid 只读取一次 stat/status，按 pid 升序排列 */
+    size_t count;
+    size_t *child_start; /* procs[i] 的子进程下标为 child_idx[child_start[i] .. child_start[i + 1]) */
+    size_t *child_idx;
+    size_t *parent_idx;  /* procs[i] 的父进程下标，父进程不在快照中时为 (size_t)-1 */
+    size_t *euler_in;    /* DFS 进入 / 离开 procs[i] 的时间戳，子树 = 时间区间的嵌套 */
+    size_t *euler_out;
+    size_t *dfs_order;   /* 先序遍历序列；procs[i] 的后代是 dfs_order[dfs_pos[i] + 1 ..] 中连续的一段 */
+    size_t *dfs_pos;
+} Snapshot;
+
+static int cmp_proc_pid(const void *a, const void *b)
+{
+    const Proc *ea = (const Proc *)a;
+    const Proc *eb = (const Proc *)b;
 
-    DIR *dir = opendir("/proc");
-    if (!dir)
+    if (ea->pid < eb->pid)
         return -1;
+    if (ea->pid > eb->pid)
+        return 1;
+    return 0;
+}
 
-    ProcList descendants = {0};
-
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
-    {
-        if (!isdigit((unsigned char)entry->d_name[0]))
-            continue;
-
-        char *end = NULL;
-        long value = strtol(entry->d_name, &end, 10);
-        if (!end || *end != '\0' || value <= 0 || value > INT_MAX)
-            continue;
-
-        pid_t pid = (pid_t)value;
-        if (pid == root_pid)
-            continue;
+static int cmp_size_t(const void *a, const void *b)
+{
+    size_t ea = *(const size_t *)a;
+    size_t eb = *(const size_t *)b;
 
-        pid_t current = pid;
-        while (current > 0)
-        {
-            pid_t parent = -1;
-            if (read_ppid_from_proc(current, &parent) != 0)
-                break;
+    if (ea < eb)
+        return -1;
+    if (ea > eb)
+        return 1;
+    return 0;
+}
 
-            if (parent == root_pid)
-            {
-                Proc proc;
-                if (read_proc_info(pid, &proc) != 0)
-                    break;
+static void free_snapshot(Snapshot *snap)
+{
+    if (!snap)
+        return;
 
-                if (append_proc(&descendants, &proc) != 0)
-                {
-                    free_proc_list(&descendants);
-                    closedir(dir);
-                    return -1;
-                }
-                break;
-            }
+    free(snap->procs);
+    free(snap->child_start);
+    free(snap->child_idx);
+    free(snap->parent_idx);
+    free(snap->euler_in);
+    free(snap->euler_out);
+    free(snap->dfs_order);
+    free(snap->dfs_pos);
+    memset(snap, 0, sizeof(*snap));
+}
 
-            if (parent <= 1 || parent == current)
-                break;
+/**
+ * 用途：在快照中二分查找 pid，返回其在 procs 中的下标；找不到时返回 (size_t)-1。
+ */
+static size_t snapshot_index(const Snapshot *snap, pid_t pid)
+{
+    size_t lo = 0;
+    size_t hi = snap->count;
 
-            current = parent;
-        }
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (snap->procs[mid].pid == pid)
+            return mid;
+        if (snap->procs[mid].pid < pid)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    return (size_t)-1;
+}
 
-    closedir(dir);
-    *descendants_out = descendants;
-    return 0;
+static const Proc *snapshot_find(const Snapshot *snap, pid_t pid)
+{
+    size_t idx = snapshot_index(snap, pid);
+    return (idx == (size_t)-1) ? NULL : &snap->procs[idx];
 }
 
 /**
- * 用途：从 /proc 中收集 process_id 的所有兄弟进程信息，保存在 siblings_out 中，并将兄弟数量保存在 siblings_count_out 中。
+ * 用途：从快照中取出 pid 的父进程 PID，保存在 ppid_out 中（替代逐级读取 /proc/<pid>/status）。
  */
-static int collect_siblings(pid_t process_id, ProcList *siblings_out)
+static int snapshot_ppid(const Snapshot *snap, pid_t pid, pid_t *ppid_out)
 {
-    if (!siblings_out)
+    const Proc *proc = snapshot_find(snap, pid);
+    if (!proc || proc->ppid < 0)
         return -1;
 
-    pid_t parent_pid = -1;
-    if (read_ppid_from_proc(process_id, &parent_pid) != 0 || parent_pid <= 0)
-        return -1;
+    *ppid_out = proc->ppid;
+    return 0;
+}
 
-    DIR *dir = opendir("/proc");
-    if (!dir)
-        return -1;
+static int snapshot_is_bash(const Snapshot *snap, pid_t pid)
+{
+    const Proc *proc = snapshot_find(snap, pid);
+    return proc ? proc->is_bash : 0;
+}
 
-    ProcList siblings = {0};
+/**
+ * 用途：根据每个进程的 ppid 建立 父→子 邻接表（CSR 形式：先计数，再前缀和，最后填充）。
+ * 由于 procs 按 pid 升序，每个父进程的子进程下标也按 pid 升序排列。
+ */
+static int build_child_index(Snapshot *snap)
+{
+    size_t n = snap->count;
+    size_t *parent_idx = snap->parent_idx = malloc((n + 1) * sizeof(*parent_idx));
+    snap->child_start = calloc(n + 1, sizeof(*snap->child_start));
+    snap->child_idx = malloc((n + 1) * sizeof(*snap->child_idx));
+    if (!parent_idx || !snap->child_start || !snap->child_idx)
+        return -1;
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
+    for (size_t i = 0; i < n; i++)
     {
-        if (!isdigit((unsigned char)entry->d_name[0]))
-            continue;
-
-        char *end = NULL;
-        long value = strtol(entry->d_name, &end, 10);
-        if (!end || *end != '\0' || value <= 0 || value > INT_MAX)
+        parent_idx[i] = (size_t)-1;
+        if (snap->procs[i].ppid <= 0 || snap->procs[i].ppid == snap->procs[i].pid)
             continue;
 
-        pid_t pid = (pid_t)value;
-        if (pid == process_id)
-            continue;
+        parent_idx[i] = snapshot_index(snap, snap->procs[i].ppid);
+        if (parent_idx[i] != (size_t)-1)
+            snap->child_start[parent_idx[i] + 1]++;
+    }
 
-        Proc proc;
-        if (read_proc_info(pid, &proc) != 0)
-            continue;
+    for (size_t i = 0; i < n; i++)
+        snap->child_start[i + 1] += snap->child_start[i];
 
-        if (proc.ppid != parent_pid)
-            continue;
+    /* fill[p] 是父进程 p 下一个子进程的写入位置 */
+    size_t *fill = malloc((n + 1) * sizeof(*fill));
+    if (!fill)
+        return -1;
+    memcpy(fill, snap->child_start, (n + 1) * sizeof(*fill));
 
-        if (append_proc(&siblings, &proc) != 0)
-        {
-            free_proc_list(&siblings);
-            closedir(dir);
-            return -1;
-        }
+    for (size_t i = 0; i < n; i++)
+    {
+        if (parent_idx[i] != (size_t)-1)
+            snap->child_idx[fill[parent_idx[i]]++] = i;
     }
 
-    closedir(dir);
-    *siblings_out = siblings;
+    free(fill);
     return 0;
 }
 
-static int cmp_proc_start_desc(const void *a, const void *b)
+/**
+ * 用途：从 start 出发做一次非递归 DFS，给子树中每个尚未访问的节点记录进入/离开时间戳和先序位置。
+ */
+static void euler_visit(Snapshot *snap, size_t start, size_t *stack, size_t *cursor, size_t *clock, size_t *order_len)
 {
-    const Proc *ea = (const Proc *)a;
-    const Proc *eb = (const Proc *)b;
+    size_t top = 0;
+    snap->euler_in[start] = (*clock)++;
+    snap->dfs_pos[start] = *order_len;
+    snap->dfs_order[(*order_len)++] = start;
+    cursor[start] = snap->child_start[start];
+    stack[top++] = start;
 
-    if (ea->start_ticks < eb->start_ticks)
-        return 1;
-    if (ea->start_ticks > eb->start_ticks)
-        return -1;
-    if (ea->pid < eb->pid)
-        return 1;
-    if (ea->pid > eb->pid)
-        return -1;
-    return 0;
+    while (top > 0)
+    {
+        size_t cur = stack[top - 1];
+        if (cursor[cur] == snap->child_start[cur + 1])
+        {
+            snap->euler_out[cur] = (*clock)++;
+            top--;
+            continue;
+        }
+
+        size_t child = snap->child_idx[cursor[cur]++];
+        if (snap->euler_in[child] != (size_t)-1) // 防御：快照中的环
+            continue;
+
+        snap->euler_in[child] = (*clock)++;
+        snap->dfs_pos[child] = *order_len;
+        snap->dfs_order[(*order_len)++] = child;
+        cursor[child] = snap->child_start[child];
+        stack[top++] = child;
+    }
 }
 
-static int is_bash_process(pid_t pid)
+/**
+ * 用途：在进程森林上做 DFS，记录每个进程的进入/离开时间戳（Euler 序）。
+ * 之后“X 是否在 R 的子树中”只需比较 euler_in/euler_out，R 的后代个数为 (euler_out - euler_in) / 2，
+ * R 的全部后代就是先序序列 dfs_order 中紧跟在 R 之后的那一段。
+ * 实现思路：
+ * 1. 先从每棵树的根（父进程不在快照中的进程）出发遍历
+ * 2. 再从仍未访问的节点出发遍历一次，保证 ppid 读取竞争造成的环也能被完整编号
+ */
+static int build_euler_index(Snapshot *snap)
 {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+    size_t n = snap->count;
+    snap->euler_in = malloc((n + 1) * sizeof(*snap->euler_in));
+    snap->euler_out = malloc((n + 1) * sizeof(*snap->euler_out));
+    snap->dfs_order = malloc((n + 1) * sizeof(*snap->dfs_order));
+    snap->dfs_pos = malloc((n + 1) * sizeof(*snap->dfs_pos));
+    size_t *stack = malloc((n + 1) * sizeof(*stack));
+    size_t *cursor = malloc((n + 1) * sizeof(*cursor));
+    if (!snap->euler_in || !snap->euler_out || !snap->dfs_order || !snap->dfs_pos || !stack || !cursor)
+    {
+        free(stack);
+        free(cursor);
+        return -1;
+    }
 
-    FILE *fp = fopen(path, "r");
-    if (!fp)
-        return 0;
+    for (size_t i = 0; i < n; i++)
+        snap->euler_in[i] = (size_t)-1;
 
-    char name[64] = {0};
-    if (!fgets(name, sizeof(name), fp))
+    size_t clock = 0;
+    size_t order_len = 0;
+    for (size_t i = 0; i < n; i++)
     {
-        fclose(fp);
-        return 0;
+        if (snap->parent_idx[i] == (size_t)-1)
+            euler_visit(snap, i, stack, cursor, &clock, &order_len);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        if (snap->euler_in[i] == (size_t)-1)
+            euler_visit(snap, i, stack, cursor, &clock, &order_len);
     }
-    fclose(fp);
 
-    name[strcspn(name, "\n")] = '\0';
-    return strcmp(name, "bash") == 0;
+    free(stack);
+    free(cursor);
+    return 0;
 }
 
-static int pid_in_list(pid_t pid, const pid_t *list, size_t count)
+/**
+ * 用途：下标为 idx 的进程的后代个数。
+ */
+static size_t snapshot_descendant_count(const Snapshot *snap, size_t idx)
 {
-    for (size_t i = 0; i < count; i++)
-    {
-        if (list[i] == pid)
-            return 1;
-    }
-    return 0;
+    return (snap->euler_out[idx] - snap->euler_in[idx]) / 2;
 }
 
-static pid_t find_current_bash_ancestor(void)
+/**
+ * 用途：下标 x 的进程是否是下标 r 的进程的后代（不含 r 本身），两次整数比较。
+ */
+static int snapshot_idx_is_descendant(const Snapshot *snap, size_t x, size_t r)
 {
-    pid_t current = getpid();
-    while (current > 1)
-    {
-        if (is_bash_process(current))
-            return current;
-
-        pid_t parent = -1;
-        if (read_ppid_from_proc(current, &parent) != 0)
-            break;
-        if (parent <= 1 || parent == current)
-            break;
-
-        current = parent;
-    }
-
-    return -1;
+    return snap->euler_in[r] < snap->euler_in[x] && snap->euler_out[x] < snap->euler_out[r];
 }
 
 /**
- * -bcp：统计当前 bash 终端（当前 shell 对应的 bash）子树中的进程总数（不含该 bash 本身）。
- * 实现思路：
- * 1. 先通过 find_current_bash_ancestor() 找到当前 bash 进程 PID
- * 2. 使用 collect_descendants(bash_pid, &descendants) 收集其全部后代
- * 3. 输出后代数量 descendants.count
+ * 用途：pid 是否属于以 root 为根的子树（pid == root 也算）。
  */
-static void opt_bcp()
+static int snapshot_in_subtree(const Snapshot *snap, pid_t pid, pid_t root)
 {
-    pid_t bash_pid = find_current_bash_ancestor();
-    if (bash_pid <= 0)
-    {
-        fprintf(stderr, "Cannot locate current bash ancestor process.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    ProcList descendants = {0};
-    if (collect_descendants(bash_pid, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of bash process %d\n", (int)bash_pid);
-        return;
-    }
+    if (pid == root)
+        return 1;
 
-    printf("%zu\n", descendants.count);
-    free_proc_list(&descendants);
+    size_t x = snapshot_index(snap, pid);
+    size_t r = snapshot_index(snap, root);
+    return x != (size_t)-1 && r != (size_t)-1 && snapshot_idx_is_descendant(snap, x, r);
 }
 
 /**
- * -bop：统计所有打开的 bash 终端子树中的进程总数（去重，不含 bash 进程本身）。
- * 实现思路：
- * 1. 遍历 /proc，收集所有 bash 进程 PID
- * 2. 对每个 bash PID 调用 collect_descendants 收集后代进程
- * 3. 将后代 PID 合并到全局列表并去重
- * 4. 输出去重后的总数量
+ * 用途：readdir("/proc")，把所有数字目录名（pid）保存到动态数组 pids_out 中，数量保存在 count_out 中。
  */
-static void opt_bop()
+static int list_proc_pids(pid_t **pids_out, size_t *count_out)
 {
     DIR *dir = opendir("/proc");
     if (!dir)
-        die_perror("opendir /proc");
+        return -1;
 
-    pid_t *bash_pids = NULL;
-    size_t bash_count = 0;
+    pid_t *pids = NULL;
+    size_t count = 0;
+    size_t cap = 0;
 
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL)
@@ -496,857 +703,2645 @@ static void opt_bop()
         if (!end || *end != '\0' || value <= 0 || value > INT_MAX)
             continue;
 
-        pid_t pid = (pid_t)value;
-        if (!is_bash_process(pid))
-            continue;
-
-        pid_t *new_list = realloc(bash_pids, (bash_count + 1) * sizeof(*bash_pids));
-        if (!new_list)
-        {
-            free(bash_pids);
-            closedir(dir);
-            die_perror("realloc");
-        }
-
-        bash_pids = new_list;
-        bash_pids[bash_count++] = pid;
-    }
-
-    closedir(dir);
-
-    pid_t *all_pids = NULL;
-    size_t all_count = 0;
-
-    for (size_t i = 0; i < bash_count; i++)
-    {
-        ProcList descendants = {0};
-        if (collect_descendants(bash_pids[i], &descendants) != 0)
-        {
-            pid_t failed_bash_pid = bash_pids[i];
-            free_proc_list(&descendants);
-            free(all_pids);
-            free(bash_pids);
-            fprintf(stderr, "Cannot collect descendants of bash process %d\n", (int)failed_bash_pid);
-            return;
-        }
-
-        for (size_t j = 0; j < descendants.count; j++)
+        if (count == cap)
         {
-            pid_t pid = descendants.proc_items[j].pid;
-            if (pid_in_list(pid, all_pids, all_count)) // 去重
-                continue;
-
-            if (append_pid(&all_pids, &all_count, pid) != 0)
+            size_t new_cap = (cap == 0) ? 512 : cap * 2;
+            pid_t *new_pids = realloc(pids, new_cap * sizeof(*new_pids));
+            if (!new_pids)
             {
-                free_proc_list(&descendants);
-                free(all_pids);
-                free(bash_pids);
-                die_perror("realloc");
+                free(pids);
+                closedir(dir);
+                return -1;
             }
+            pids = new_pids;
+            cap = new_cap;
         }
-
-        free_proc_list(&descendants);
+        pids[count++] = (pid_t)value;
     }
 
-    printf("%zu\n", all_count);
-    free(all_pids);
-    free(bash_pids);
+    closedir(dir);
+    *pids_out = pids;
+    *count_out = count;
+    return 0;
 }
 
+/* 用途：一个扫描线程负责的 pid 区间 [begin, end)，结果直接写入共享进程表中对应的槽位。 */
+typedef struct ScanChunk
+{
+    const pid_t *pids;
+    Proc *procs;
+    size_t begin;
+    size_t end;
+} ScanChunk;
+
 /**
- * 默认功能（无选项）：判断 process_id 是否属于以 root_process 为根的子树。
- * 实现思路：
- * 1. 从 process_id 出发沿父链向上回溯
- * 2. 若回溯过程中遇到 root_process，则输出 "process_id root_process"
- * 3. 若未遇到 root_process，则输出不属于该子树的提示信息并返回失败
+ * 用途：扫描线程入口。每个线程只写自己区间内的槽位，因此不需要任何锁；读取失败（进程已退出）的槽位 pid 置 0。
  */
-static int opt_default(pid_t process_id, pid_t root_process)
+static void *scan_chunk_worker(void *arg)
 {
-    pid_t current = process_id;
+    ScanChunk *chunk = (ScanChunk *)arg;
 
-    while (current > 0)
+    for (size_t i = chunk->begin; i < chunk->end; i++)
     {
-        if (current == root_process)
-        {
-            printf("%d %d\n", (int)process_id, (int)root_process);
-            return 0;
-        }
-
-        pid_t parent = -1;
-        if (read_ppid_from_proc(current, &parent) != 0)
-            break;
-
-        if (parent <= 0 || parent == current)
-            break;
-
-        current = parent;
+        if (read_proc_info(chunk->pids[i], &chunk->procs[i]) != 0)
+            chunk->procs[i].pid = 0;
     }
-
-    printf("Process %d does not belong to the process subtree rooted at %d\n",
-           (int)process_id, (int)root_process);
-    return -1;
+    return NULL;
 }
 
 /**
- * -cnt：统计 process_id 的后代总数。
- * 实现思路：遍历 /proc 中的每个 pid，对每个 pid 向上追父链，如果在追溯过程中遇到 process_id 就计数 +1
+ * 用途：用 nthreads 个线程读取 pids 中每个进程的信息，填入预先分配好的 procs（与 pids 一一对应）。
+ * nthreads <= 1 时直接在当前线程串行读取；线程创建失败时由当前线程补做该区间，结果与串行路径完全一致。
  */
-static void opt_cnt(pid_t process_id)
+static void scan_procs(const pid_t *pids, Proc *procs, size_t count, int nthreads)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+    if (nthreads < 1)
+        nthreads = 1;
+    if ((size_t)nthreads > count)
+        nthreads = (count == 0) ? 1 : (int)count;
+
+    ScanChunk *chunks = calloc((size_t)nthreads, sizeof(*chunks));
+    pthread_t *threads = calloc((size_t)nthreads, sizeof(*threads));
+    int *started = calloc((size_t)nthreads, sizeof(*started));
+    if (!chunks || !threads || !started)
+    {
+        free(chunks);
+        free(threads);
+        free(started);
+        ScanChunk all = {pids, procs, 0, count};
+        scan_chunk_worker(&all);
         return;
     }
 
-    printf("%zu\n", descendants.count);
-    free_proc_list(&descendants);
-}
-
-/**
- * -oct：统计 process_id 的后代中孤儿进程的数量。
- * 实现思路：
- * 1. 用 collect_descendants(process_id, &subtree_procs) 收集所有后代
- * 2. 遍历每个后代，读取其当前父进程 pid
- * 3. 排除直接子进程（parent == process_id）
- * 4. 若父进程是 1，或父进程已不在该后代集合中，则计为孤儿并累加
- */
-static void opt_oct(pid_t process_id)
-{
-    ProcList subtree_procs = {0};
-    if (collect_descendants(process_id, &subtree_procs) != 0)
+    for (int t = 0; t < nthreads; t++)
     {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
+        chunks[t].pids = pids;
+        chunks[t].procs = procs;
+        chunks[t].begin = count * (size_t)t / (size_t)nthreads;
+        chunks[t].end = count * (size_t)(t + 1) / (size_t)nthreads;
     }
 
-    long orphan_count = 0;
-    for (size_t i = 0; i < subtree_procs.count; i++)
-    {
-        pid_t parent = subtree_procs.proc_items[i].ppid;
-        if (parent <= 0)
-            continue;
+    /* 第 0 段由当前线程自己处理 */
+    for (int t = 1; t < nthreads; t++)
+        started[t] = (pthread_create(&threads[t], NULL, scan_chunk_worker, &chunks[t]) == 0);
 
-        if (parent == process_id)
-            continue;
+    scan_chunk_worker(&chunks[0]);
 
-        if (parent == 1 || !proc_pid_in_list(parent, subtree_procs.proc_items, subtree_procs.count))
-            orphan_count++;
+    for (int t = 1; t < nthreads; t++)
+    {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+        else
+            scan_chunk_worker(&chunks[t]);
     }
 
-    free_proc_list(&subtree_procs);
-    printf("%ld\n", orphan_count);
+    free(chunks);
+    free(threads);
+    free(started);
 }
 
 /**
- * -dtm：向 process_id 的所有后代发送 SIGKILL 信号并终止，按创建时间从晚到早执行。
+ * 用途：遍历一次 /proc，把每个 pid 的信息读入快照，并建立子进程邻接表。
  * 实现思路：
- * 1. 用 collect_descendants(process_id, &descendants) 收集所有后代
- * 2. 使用 qsort 按 starttime 降序排序（晚创建的先处理）
- * 3. 依次向每个后代发送 SIGKILL
- * 4. 跳过 bash 进程，ESRCH 忽略，其它错误打印提示
+ * 1. list_proc_pids() 取得 pid 列表，按数量预先分配进程表
+ * 2. scan_procs() 用 nthreads 个线程分段读取，每个 pid 只调用一次 read_proc_info()
+ * 3. 压缩掉已退出进程的槽位，按 pid 排序，之后可以二分查找
+ * 4. 调用 build_child_index() 建立 父→子 邻接表，后代/兄弟/祖先查询都在内存中完成
+ * 5. 调用 build_euler_index() 记录 DFS 进入/离开时间戳，子树成员判断和后代计数都是 O(1)
  */
-static void opt_dtm(pid_t process_id)
+static int snapshot_build(Snapshot *snap, int nthreads)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
-    }
+    if (!snap)
+        return -1;
+    memset(snap, 0, sizeof(*snap));
 
-    if (descendants.count == 0)
+    pid_t *pids = NULL;
+    size_t pid_count = 0;
+    if (list_proc_pids(&pids, &pid_count) != 0)
+        return -1;
+
+    snap->procs = malloc((pid_count + 1) * sizeof(*snap->procs));
+    if (!snap->procs)
     {
-        free_proc_list(&descendants);
-        return;
+        free(pids);
+        return -1;
     }
 
-    qsort(descendants.proc_items, descendants.count, sizeof(*descendants.proc_items), cmp_proc_start_desc);
+    scan_procs(pids, snap->procs, pid_count, nthreads);
+    free(pids);
 
-    for (size_t i = 0; i < descendants.count; i++)
+    for (size_t i = 0; i < pid_count; i++)
     {
-        pid_t pid = descendants.proc_items[i].pid;
-        if (descendants.proc_items[i].is_bash)
-        {
-            fprintf(stderr, "Process %d is BASH and will not be terminated\n", pid);
+        if (snap->procs[i].pid == 0) // 进程可能已经退出，读取失败时跳过
             continue;
-        }
+        snap->procs[snap->count++] = snap->procs[i];
+    }
 
-        if (kill(pid, SIGKILL) != 0)
-        {
-            if (errno == ESRCH)
-            {
-                fprintf(stderr, "Failed to terminate %d: %s\n", pid, strerror(errno));
-                continue;
-            }
+    qsort(snap->procs, snap->count, sizeof(*snap->procs), cmp_proc_pid);
 
-            fprintf(stderr, "Failed to kill %d: %s\n", (int)pid, strerror(errno));
-        }
+    if (build_child_index(snap) != 0 || build_euler_index(snap) != 0)
+    {
+        free_snapshot(snap);
+        return -1;
     }
-
-    free_proc_list(&descendants);
+    return 0;
 }
 
 /**
- * -odt：找出 process_id 后代中最早创建的进程并输出其 PID 与创建时间。
+ * 从快照中收集 root_pid 的所有后代进程信息，保存在 descendants_out 中（按 pid 升序）。
  * 实现思路：
- * 1. 用 collect_descendants(process_id, &descendants) 收集所有后代
- * 2. 遍历找到 start_ticks 最小的后代；若并列则取 PID 更小者
- * 3. 结合系统 btime 与时钟频率将 start_ticks 转换为可读时间字符串
- * 4. 按指定格式输出最老后代 PID 与创建时间
+ * root_pid 的后代是先序序列 dfs_order 中紧跟在它后面的连续一段，长度由 Euler 时间戳直接算出，不需要再遍历树。
  */
-static void opt_odt(pid_t process_id)
+static int collect_descendants(const Snapshot *snap, pid_t root_pid, ProcList *descendants_out)
 {
+    if (!snap || !descendants_out)
+        return -1;
+
     ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
+    size_t root_idx = snapshot_index(snap, root_pid);
+    size_t found_count = (root_idx == (size_t)-1) ? 0 : snapshot_descendant_count(snap, root_idx);
+    if (found_count == 0)
     {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
+        *descendants_out = descendants;
+        return 0;
     }
 
-    if (descendants.count == 0)
+    size_t *found = malloc(found_count * sizeof(*found));
+    descendants.proc_items = malloc(found_count * sizeof(*descendants.proc_items));
+    if (!found || !descendants.proc_items)
     {
-        free_proc_list(&descendants);
-        return;
+        free(found);
+        free(descendants.proc_items);
+        return -1;
     }
+    memcpy(found, snap->dfs_order + snap->dfs_pos[root_idx] + 1, found_count * sizeof(*found));
 
-    size_t oldest_idx = (size_t)-1;
-    for (size_t i = 0; i < descendants.count; i++)
-    {
-        if (descendants.proc_items[i].start_ticks < 0)
-            continue;
+    /* 下标升序即 pid 升序，与逐个扫描 /proc 时的输出顺序一致 */
+    qsort(found, found_count, sizeof(*found), cmp_size_t);
 
-        if (oldest_idx == (size_t)-1)
-        {
-            oldest_idx = i;
-            continue;
-        }
+    for (size_t i = 0; i < found_count; i++)
+        descendants.proc_items[i] = snap->procs[found[i]];
+    descendants.count = found_count;
 
-        if (descendants.proc_items[i].start_ticks < descendants.proc_items[oldest_idx].start_ticks)
-            oldest_idx = i;
-        else if (descendants.proc_items[i].start_ticks == descendants.proc_items[oldest_idx].start_ticks &&
-                 descendants.proc_items[i].pid < descendants.proc_items[oldest_idx].pid)
-            oldest_idx = i;
-    }
+    free(found);
+    *descendants_out = descendants;
+    return 0;
+}
 
-    if (oldest_idx != (size_t)-1)
+/**
+ * 用途：从快照中收集 process_id 的所有兄弟进程信息（同一父进程的其它子进程），保存在 siblings_out 中。
+ */
+static int collect_siblings(const Snapshot *snap, pid_t process_id, ProcList *siblings_out)
+{
+    if (!snap || !siblings_out)
+        return -1;
+
+    pid_t parent_pid = -1;
+    if (snapshot_ppid(snap, process_id, &parent_pid) != 0 || parent_pid <= 0)
+        return -1;
+
+    size_t parent_idx = snapshot_index(snap, parent_pid);
+    if (parent_idx == (size_t)-1)
+        return -1;
+
+    ProcList siblings = {0};
+    for (size_t c = snap->child_start[parent_idx]; c < snap->child_start[parent_idx + 1]; c++)
     {
-        time_t boot_time = 0;
-        long clk_tck = sysconf(_SC_CLK_TCK);
-        char time_buf[128] = "unknown";
+        const Proc *proc = &snap->procs[snap->child_idx[c]];
+        if (proc->pid == process_id)
+            continue;
 
-        if (clk_tck > 0 && read_boot_time_epoch(&boot_time) == 0)
+        if (append_proc(&siblings, proc) != 0)
         {
-            time_t creation_time = boot_time +
-                                   (time_t)(descendants.proc_items[oldest_idx].start_ticks / clk_tck);
-            struct tm tm_local;
-            if (localtime_r(&creation_time, &tm_local) != NULL)
-            {
-                if (strftime(time_buf, sizeof(time_buf), "%a %d %b %Y %I:%M:%S %p %Z", &tm_local) == 0)
-                    strcpy(time_buf, "unknown");
-            }
+            free_proc_list(&siblings);
+            return -1;
         }
+    }
 
-        printf("Oldest descendant of %d is %d, whose creation time is %s\n",
-               (int)process_id,
-               (int)descendants.proc_items[oldest_idx].pid,
-               time_buf);
+    *siblings_out = siblings;
+    return 0;
+}
+
+static int pid_in_list(pid_t pid, const pid_t *list, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (list[i] == pid)
+            return 1;
     }
+    return 0;
+}
 
-    free_proc_list(&descendants);
+static double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
 }
 
 /**
- * -ndt：找出 process_id 后代中最新创建的进程并输出其 PID。
- * 实现思路：
- * 1. 用 collect_descendants(process_id, &descendants) 收集所有后代
- * 2. 遍历找到 start_ticks 最大的后代；若并列则取 PID 更小者
- * 3. 输出该后代 PID
+ * 用途：把 RLIMIT_NOFILE 的软限制提高到硬限制，watch 模式和 kill 引擎需要同时保持大量 fd。
  */
-static void opt_ndt(pid_t process_id)
+static void raise_fd_limit(void)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
     {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
     }
+}
 
-    if (descendants.count == 0)
-    {
-        free_proc_list(&descendants);
-        return;
-    }
+static void close_if_open(int fd)
+{
+    if (fd >= 0)
+        close(fd);
+}
 
-    size_t newest_idx = (size_t)-1;
-    for (size_t i = 0; i < descendants.count; i++)
-    {
-        if (descendants.proc_items[i].start_ticks < 0)
-            continue;
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
 
-        if (newest_idx == (size_t)-1)
-        {
-            newest_idx = i;
-            continue;
-        }
+/* kill 引擎：整个终止过程（冻结 + 终止 + 收敛检查）的时间上限（秒） */
+#define KILL_DEADLINE_SECONDS 30.0
+/* kill 引擎：不用于 pidfd 的 fd 个数，留给扫描线程和 stdio */
+#define KILL_RESERVED_FDS 256
 
-        if (descendants.proc_items[i].start_ticks > descendants.proc_items[newest_idx].start_ticks)
-            newest_idx = i;
-        else if (descendants.proc_items[i].start_ticks == descendants.proc_items[newest_idx].start_ticks &&
-                 descendants.proc_items[i].pid < descendants.proc_items[newest_idx].pid)
-            newest_idx = i;
-    }
+/* 用途：kill 引擎要终止的进程集合相对于 root 的范围。 */
+typedef enum KillScope
+{
+    KILL_DESCENDANTS,  /* -dtm：所有后代 */
+    KILL_CHILDREN,     /* -kcp：直接子进程 */
+    KILL_GRANDCHILDREN /* -kgc：孙子进程 */
+} KillScope;
 
-    if (newest_idx != (size_t)-1)
-        printf("%d\n", (int)descendants.proc_items[newest_idx].pid);
+/* 用途：一个已冻结、等待终止的进程。pidfd 为 -1 表示内核不支持 pidfd 或 fd 不够用，退回到按 pid 发信号。 */
+typedef struct KillTarget
+{
+    pid_t pid;
+    int pidfd;
+    long long start_ticks;
+} KillTarget;
 
-    free_proc_list(&descendants);
+typedef struct KillEngine
+{
+    pid_t root;
+    KillScope scope;
+    int scan_threads;
+    int use_pidfd;
+    KillTarget *targets;
+    size_t count;
+    size_t cap;
+    PidIndex held;   /* pid → targets 下标，避免同一轮重复冻结 */
+    PidIndex denied; /* 没有权限发信号的进程，之后各轮不再尝试 */
+    size_t pidfds_open;
+    size_t pidfd_budget; /* 同时持有的 pidfd 上限，给扫描 /proc 留出 fd；超出的目标按 pid 发信号 */
+    size_t killed;
+    int rounds;
+} KillEngine;
+
+static int sys_pidfd_open(pid_t pid)
+{
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+static int sys_pidfd_send_signal(int pidfd, int sig)
+{
+    return (int)syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
 }
 
 /**
- * -dnd：统计 process_id 的非直接后代数量（即后代总数减去直接子进程数）。
- * 实现思路：
- * 1. 用 collect_descendants(process_id, &descendants) 拿到所有后代
- * 2. 统计直接子进程数（ppid == process_id）
- * 3. 计算非直接后代数：descendants.count - direct_children_count
- * 4. 输出该数量
+ * 用途：重新读取 /proc/<pid>/stat，确认 pid 仍是快照中的那个进程（starttime 相同）且还活着。
  */
-static void opt_dnd(pid_t process_id)
+static int proc_still_same(const Proc *proc)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)proc->pid);
+
+    Proc now;
+    ssize_t len = read_small_file(path, proc_read_buf, sizeof(proc_read_buf));
+    if (len <= 0 || parse_proc_stat(proc_read_buf, (size_t)len, &now) != 0)
+        return 0;
+    return now.start_ticks == proc->start_ticks && now.state != 'Z' && now.state != 'X';
+}
+
+/**
+ * 用途：为快照中的进程打开 pidfd，并确认 pid 没有被复用。
+ * 返回 pidfd；进程已退出或 pid 已被复用时返回 -1；内核不支持 pidfd（或 fd 用尽）时返回 -2，调用方改用 kill()。
+ */
+static int pidfd_open_verified(const Proc *proc)
+{
+    int pidfd = sys_pidfd_open(proc->pid);
+    int open_errno = errno;
+    if (pidfd < 0 && open_errno == ESRCH)
+        return -1;
+
+    /* 先拿到 pidfd 再核对 starttime：核对通过后，pidfd 指向的一定是快照中的那个进程 */
+    if (!proc_still_same(proc))
     {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
+        close_if_open(pidfd);
+        return -1;
     }
-
-    size_t direct_children_count = 0;
-    for (size_t i = 0; i < descendants.count; i++)
+    if (pidfd < 0)
     {
-        if (descendants.proc_items[i].ppid == process_id)
-            direct_children_count++;
+        errno = open_errno;
+        return -2;
     }
+    return pidfd;
+}
 
-    size_t non_direct_count = descendants.count - direct_children_count;
-    printf("%zu\n", non_direct_count);
-
-    free_proc_list(&descendants);
+static int kill_target_signal(const KillTarget *target, int sig)
+{
+    if (target->pidfd >= 0)
+        return sys_pidfd_send_signal(target->pidfd, sig);
+    return kill(target->pid, sig);
 }
 
 /**
- * -sst：向 process_id 的所有兄弟进程发送 SIGSTOP 信号，要求它们暂停。
- * 实现思路：
- * 1. 复用 collect_siblings(process_id, &siblings) 收集兄弟进程
- * 2. 跳过 bash 进程，避免影响用户 shell
- * 3. 对其余兄弟进程发送 SIGSTOP
+ * 用途：冻结一个候选进程并加入本轮的目标集合。返回 1 表示新加入，0 表示已在集合中、已退出或 pid 已被复用。
  */
-static void opt_sst(pid_t process_id)
+static int kill_engine_hold(KillEngine *engine, const Proc *proc)
 {
-    ProcList siblings = {0};
-    if (collect_siblings(process_id, &siblings) != 0)
+    if (proc->state == 'Z' || proc->state == 'X' || pid_index_get(&engine->held, proc->pid) != (size_t)-1 ||
+        pid_index_get(&engine->denied, proc->pid) != (size_t)-1)
+        return 0;
+
+    int pidfd = -1;
+    if (engine->use_pidfd && engine->pidfds_open < engine->pidfd_budget)
     {
-        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
-        return;
+        pidfd = pidfd_open_verified(proc);
+        if (pidfd == -1)
+            return 0;
+        if (pidfd == -2)
+        {
+            if (errno == ENOSYS)
+                engine->use_pidfd = 0;
+            pidfd = -1;
+        }
+    }
+    else if (!proc_still_same(proc))
+    {
+        return 0;
     }
 
-    for (size_t i = 0; i < siblings.count; i++)
+    KillTarget target = {proc->pid, pidfd, proc->start_ticks};
+
+    /* 冻结后它不能再 fork，父子关系也保持不变，下一次扫描就能看到它在冻结前生出的子进程 */
+    if (kill_target_signal(&target, SIGSTOP) != 0)
     {
-        pid_t pid = siblings.proc_items[i].pid;
-        if (siblings.proc_items[i].is_bash)
+        if (errno == EPERM)
         {
-            fprintf(stderr, "Process %d is BASH and will not be stopped\n", (int)pid);
-            continue;
+            fprintf(stderr, "Failed to kill %d: %s\n", (int)proc->pid, strerror(errno));
+            pid_index_put(&engine->denied, proc->pid, 0);
         }
+        close_if_open(pidfd);
+        return 0;
+    }
 
-        if (kill(pid, SIGSTOP) != 0)
+    if (engine->count == engine->cap)
+    {
+        size_t new_cap = (engine->cap == 0) ? 256 : engine->cap * 2;
+        KillTarget *new_targets = realloc(engine->targets, new_cap * sizeof(*new_targets));
+        if (!new_targets)
         {
-            if (errno == ESRCH)
-                continue;
-
-            fprintf(stderr, "Failed to stop %d: %s\n", (int)pid, strerror(errno));
+            close_if_open(pidfd);
+            die_perror("realloc");
         }
+        engine->targets = new_targets;
+        engine->cap = new_cap;
+    }
+    if (pid_index_put(&engine->held, proc->pid, engine->count) != 0)
+    {
+        close_if_open(pidfd);
+        die_perror("malloc");
     }
 
-    free_proc_list(&siblings);
+    engine->targets[engine->count++] = target;
+    if (pidfd >= 0)
+        engine->pidfds_open++;
+    return 1;
 }
 
 /**
- * -sco：向 process_id 的所有已暂停兄弟进程发送 SIGCONT 信号，要求它们继续执行。
- * 实现思路：
- * 1. 复用 collect_siblings(process_id, &siblings) 收集兄弟进程
- * 2. 跳过 bash 进程，避免影响用户 shell
- * 3. 仅对状态为 T（stopped）的兄弟进程发送 SIGCONT
+ * 用途：若 proc 是要终止的目标就把它冻结并加入集合。report_bash 为 1 时对跳过的 bash 进程打印提示。
+ * 快照中看到的状态还不是“已停止”的目标计入 running（SIGSTOP 是异步生效的）。
  */
-static void opt_sco(pid_t process_id)
+static void kill_engine_consider(KillEngine *engine, const Proc *proc, int report_bash, size_t *running)
 {
-    ProcList siblings = {0};
-    if (collect_siblings(process_id, &siblings) != 0)
+    if (proc->is_bash)
     {
-        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
+        if (report_bash)
+            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)proc->pid);
         return;
     }
+    if (proc->state == 'Z' || proc->state == 'X')
+        return;
 
-    for (size_t i = 0; i < siblings.count; i++)
-    {
-        pid_t pid = siblings.proc_items[i].pid;
-
-        if (siblings.proc_items[i].is_bash)
-        {
-            fprintf(stderr, "Process %d is BASH and will not be continued\n", (int)pid);
-            continue;
-        }
+    kill_engine_hold(engine, proc);
+    if (proc->state != 'T' && proc->state != 't')
+        (*running)++;
+}
 
-        if (siblings.proc_items[i].state != 'T')
-            continue;
+/**
+ * 用途：按 engine->scope 从快照中选出目标并冻结，返回快照中还没有处于停止状态的目标个数。
+ */
+static size_t kill_engine_select(KillEngine *engine, const Snapshot *snap, int report_bash)
+{
+    size_t root_idx = snapshot_index(snap, engine->root);
+    if (root_idx == (size_t)-1)
+        return 0;
 
-        if (kill(pid, SIGCONT) != 0)
+    size_t running = 0;
+    if (engine->scope != KILL_DESCENDANTS)
+    {
+        for (size_t c = snap->child_start[root_idx]; c < snap->child_start[root_idx + 1]; c++)
         {
-            if (errno == ESRCH)
+            size_t child = snap->child_idx[c];
+            if (engine->scope == KILL_CHILDREN)
+            {
+                kill_engine_consider(engine, &snap->procs[child], report_bash, &running);
                 continue;
-
-            fprintf(stderr, "Failed to continue %d: %s\n", (int)pid, strerror(errno));
+            }
+            for (size_t g = snap->child_start[child]; g < snap->child_start[child + 1]; g++)
+                kill_engine_consider(engine, &snap->procs[snap->child_idx[g]], report_bash, &running);
         }
+        return running;
     }
 
-    free_proc_list(&siblings);
+    /* 全部后代是先序序列中紧跟在 root 之后的一段 */
+    size_t first = snap->dfs_pos[root_idx] + 1;
+    size_t last = first + snapshot_descendant_count(snap, root_idx);
+    for (size_t pos = first; pos < last; pos++)
+        kill_engine_consider(engine, &snap->procs[snap->dfs_order[pos]], report_bash, &running);
+    return running;
+}
+
+static int cmp_kill_target_start_desc(const void *a, const void *b)
+{
+    const KillTarget *ea = (const KillTarget *)a;
+    const KillTarget *eb = (const KillTarget *)b;
+
+    if (ea->start_ticks != eb->start_ticks)
+        return (ea->start_ticks < eb->start_ticks) ? 1 : -1;
+    return (ea->pid < eb->pid) ? 1 : (ea->pid > eb->pid) ? -1 : 0;
 }
 
 /**
- * -kgp：向 process_id 的祖父进程发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程，以免影响用户的正常操作。
- * 实现思路：
- * 1. 先读取 process_id 的父进程 PPID，记为 parent_pid
- * 2. 再读取 parent_pid 的父进程 PPID，记为 grandparent_pid
- * 3. 如果 grandparent_pid 不存在或者不大于 1，则不执行终止
- * 4. 如果 grandparent_pid 是 bash 进程，则不执行终止
- * 5. 否则，向 grandparent_pid 发送 SIGKILL 信号
+ * 用途：向本轮冻结的全部目标发送 SIGKILL（晚创建的先处理），再通过 pidfd 等待它们真正退出（最多到 deadline）。
  */
-static void opt_kgp(pid_t process_id)
+static void kill_engine_fire(KillEngine *engine, double deadline)
 {
-    pid_t parent_pid = -1;
-    if (read_ppid_from_proc(process_id, &parent_pid) != 0 || parent_pid <= 0)
-    {
-        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
-        return;
-    }
+    qsort(engine->targets, engine->count, sizeof(*engine->targets), cmp_kill_target_start_desc);
 
-    pid_t grandparent_pid = -1;
-    if (read_ppid_from_proc(parent_pid, &grandparent_pid) != 0 || grandparent_pid <= 0)
+    for (size_t i = 0; i < engine->count; i++)
     {
-        fprintf(stderr, "Cannot determine grandparent process of %d\n", (int)process_id);
-        return;
+        if (kill_target_signal(&engine->targets[i], SIGKILL) == 0)
+        {
+            engine->killed++;
+        }
+        else if (errno != ESRCH)
+        {
+            fprintf(stderr, "Failed to kill %d: %s\n", (int)engine->targets[i].pid, strerror(errno));
+        }
     }
 
-    if (grandparent_pid <= 1) // 为系统进程，不能杀死
-    {
-        fprintf(stderr, "Grandparent is not a user process and will not be terminated\n");
-        return;
-    }
+    /* pidfd 可读表示进程已退出；没有 pidfd 的目标交给下一轮扫描确认 */
+    struct pollfd *fds = malloc((engine->count + 1) * sizeof(*fds));
+    if (!fds)
+        die_perror("malloc");
 
-    if (is_bash_process(grandparent_pid))
+    size_t pending = 0;
+    for (size_t i = 0; i < engine->count; i++)
     {
-        fprintf(stderr, "Grandparent is BASH and will not be terminated\n");
-        return;
+        if (engine->targets[i].pidfd < 0)
+            continue;
+        fds[pending].fd = engine->targets[i].pidfd;
+        fds[pending].events = POLLIN;
+        pending++;
     }
 
-    if (kill(grandparent_pid, SIGKILL) != 0)
+    while (pending > 0)
     {
-        if (errno == ESRCH)
+        double left = deadline - monotonic_seconds();
+        if (left <= 0)
+            break;
+        if (poll(fds, pending, (int)(left * 1000) + 1) < 0)
         {
-            fprintf(stderr, "Grandparent process %d no longer exists\n", (int)grandparent_pid);
-            return;
+            if (errno == EINTR)
+                continue;
+            break;
         }
 
-        fprintf(stderr, "Failed to kill grandparent %d: %s\n", (int)grandparent_pid, strerror(errno));
-        return;
+        size_t keep = 0;
+        for (size_t i = 0; i < pending; i++)
+        {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)))
+                fds[keep++] = fds[i];
+        }
+        pending = keep;
     }
+    free(fds);
 
-    printf("SIGKILL was sent to process %d\n", (int)grandparent_pid);
+    for (size_t i = 0; i < engine->count; i++)
+        close_if_open(engine->targets[i].pidfd);
+    engine->count = 0;
+    engine->pidfds_open = 0;
+    pid_index_clear(&engine->held);
 }
 
 /**
- * -kpp：向 process_id 的父进程发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * 用途：分阶段终止 root 的子树（范围由 scope 决定），并重复扫描直到子树中不再有活着的目标。
  * 实现思路：
- * 1. 先读取 process_id 的父进程 PPID，记为 parent_pid
- * 2. 如果 parent_pid 不存在或者不大于 1，就说明 process_id 没有父进程或者父进程是 init 进程了，这时不杀死 parent_pid
- * 3. 如果 parent_pid 是 bash 进程，就不杀死 parent_pid
- * 4. 否则，向 parent_pid 发送 SIGKILL 信号
+ * 1. 冻结：对快照中的每个目标先 pidfd_open 并核对 starttime（防止 pid 复用），再发 SIGSTOP；
+ *    重新扫描，冻结上一次扫描之后才出现的目标，直到连续两次扫描看到的目标都已处于停止状态
+ * 2. 终止：通过 pidfd_send_signal 向全部冻结的目标发 SIGKILL，并用 poll 等待各 pidfd 报告退出
+ * 3. 收敛检查：再扫描一次，仍有活着的目标（僵尸进程不算）就进入下一轮
+ * 整个过程受 KILL_DEADLINE_SECONDS 限制；内核不支持 pidfd 时退回到 kill()。
+ * 返回 0 表示已收敛，-1 表示到达时间上限。
  */
-static void opt_kpp(pid_t process_id)
+static int kill_engine_run(KillEngine *engine, const Snapshot *first)
 {
-    pid_t parent_pid = -1;
-    if (read_ppid_from_proc(process_id, &parent_pid) != 0 || parent_pid <= 0)
-    {
-        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
-        return;
-    }
+    double deadline = monotonic_seconds() + KILL_DEADLINE_SECONDS;
+    raise_fd_limit();
 
-    if (parent_pid <= 1)
-    {
-        fprintf(stderr, "Parent is not a user process and will not be terminated\n");
-        return;
-    }
+    struct rlimit rl;
+    engine->pidfd_budget = 0;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur > KILL_RESERVED_FDS)
+        engine->pidfd_budget = (rl.rlim_cur == RLIM_INFINITY) ? (size_t)-1 : (size_t)(rl.rlim_cur - KILL_RESERVED_FDS);
 
-    if (is_bash_process(parent_pid))
-    {
-        fprintf(stderr, "Parent is BASH and will not be terminated\n");
-        return;
-    }
+    const Snapshot *snap = first;
+    Snapshot fresh;
+    int have_fresh = 0;
+    int rc = 0;
 
-    if (kill(parent_pid, SIGKILL) != 0)
+    while (1)
     {
-        if (errno == ESRCH)
+        /* 阶段 1：冻结。一次扫描看到全部目标都已停止后，再扫描一次：这次列出的 pid 一定包含
+         * 它们停止前 fork 出的全部子进程；如果这次仍然全部已停止，子树就彻底冻结了 */
+        int stopped_before = 0;
+        while (1)
         {
-            fprintf(stderr, "Parent process %d no longer exists\n", (int)parent_pid);
-            return;
+            size_t running = kill_engine_select(engine, snap, snap == first);
+            if (have_fresh)
+            {
+                free_snapshot(&fresh);
+                have_fresh = 0;
+            }
+            if ((running == 0 && (stopped_before || engine->count == 0)) || monotonic_seconds() >= deadline)
+                break;
+            stopped_before = (running == 0);
+
+            if (snapshot_build(&fresh, engine->scan_threads) != 0)
+                break;
+            have_fresh = 1;
+            snap = &fresh;
         }
 
-        fprintf(stderr, "Failed to kill parent %d: %s\n", (int)parent_pid, strerror(errno));
-        return;
+        if (engine->count == 0)
+            break; // 收敛：没有活着的目标
+
+        /* 阶段 2：终止（到达时间上限时也要执行，不能把冻结的进程留在原地） */
+        engine->rounds++;
+        kill_engine_fire(engine, deadline);
+
+        if (monotonic_seconds() >= deadline)
+        {
+            rc = -1;
+            break;
+        }
+
+        /* 阶段 3：收敛检查 */
+        if (snapshot_build(&fresh, engine->scan_threads) != 0)
+        {
+            rc = -1;
+            break;
+        }
+        have_fresh = 1;
+        snap = &fresh;
     }
 
-    printf("SIGKILL was sent to process %d\n", (int)parent_pid);
+    if (have_fresh)
+        free_snapshot(&fresh);
+    return rc;
 }
 
 /**
- * -ksp：向 process_id 的所有兄弟进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程，以免影响用户的正常操作。
- * 实现思路：
- * 1. 复用 collect_siblings(process_id, &siblings) 收集兄弟进程
- * 2. 对每个 sibling 发送 SIGKILL
- * 3. 遵守保护规则：bash sibling 不终止并提示
- * 4. 错误处理：ESRCH 忽略，其它错误打印原因
+ * 用途：-dtm / -kcp / -kgc 的公共入口：运行 kill 引擎并在 stderr 报告轮数。
  */
-static void opt_ksp(pid_t process_id)
+static void kill_subtree(const Snapshot *snap, pid_t process_id, KillScope scope, int scan_threads)
 {
-    ProcList siblings = {0};
-    if (collect_siblings(process_id, &siblings) != 0)
-    {
-        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
-        return;
-    }
+    KillEngine engine;
+    memset(&engine, 0, sizeof(engine));
+    engine.root = process_id;
+    engine.scope = scope;
+    engine.scan_threads = scan_threads;
+    engine.use_pidfd = 1;
+
+    int rc = kill_engine_run(&engine, snap);
+    if (rc != 0)
+        fprintf(stderr, "Subtree of %d did not converge within %.0f s: %zu processes killed in %d rounds\n",
+                (int)process_id, KILL_DEADLINE_SECONDS, engine.killed, engine.rounds);
+    else if (engine.killed > 0)
+        fprintf(stderr, "Killed %zu processes in %d rounds\n", engine.killed, engine.rounds);
+
+    free(engine.targets);
+    pid_index_free(&engine.held);
+    pid_index_free(&engine.denied);
+}
 
-    for (size_t i = 0; i < siblings.count; i++)
+static pid_t find_current_bash_ancestor(const Snapshot *snap)
+{
+    pid_t current = getpid();
+    while (current > 1)
     {
-        pid_t pid = siblings.proc_items[i].pid;
-
-        if (siblings.proc_items[i].is_bash)
-        {
-            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)pid);
-            continue;
-        }
+        if (snapshot_is_bash(snap, current))
+            return current;
 
-        if (kill(pid, SIGKILL) != 0)
-        {
-            if (errno == ESRCH)
-                continue;
+        pid_t parent = -1;
+        if (snapshot_ppid(snap, current, &parent) != 0)
+            break;
+        if (parent <= 1 || parent == current)
+            break;
 
-            fprintf(stderr, "Failed to kill sibling %d: %s\n", (int)pid, strerror(errno));
-        }
+        current = parent;
     }
 
-    free_proc_list(&siblings);
+    return -1;
 }
 
 /**
- * -kps：向 process_id 的父进程的所有兄弟进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * -bcp：统计当前 bash 终端（当前 shell 对应的 bash）子树中的进程总数（不含该 bash 本身）。
  * 实现思路：
- * 1. 先读取 process_id 的父进程 parent_pid
- * 2. 复用 collect_siblings(parent_pid, &parent_siblings) 获取“父进程的 siblings（叔伯）”
- * 3. 对这些进程发送 SIGKILL
+ * 1. 先通过 find_current_bash_ancestor() 找到当前 bash 进程 PID
+ * 2. 使用 collect_descendants(snap, bash_pid, &descendants) 收集其全部后代
+ * 3. 输出后代数量 descendants.count
  */
-static void opt_kps(pid_t process_id)
+static void opt_bcp(const Snapshot *snap)
 {
-    pid_t parent_pid = -1;
-    if (read_ppid_from_proc(process_id, &parent_pid) != 0 || parent_pid <= 0)
+    pid_t bash_pid = find_current_bash_ancestor(snap);
+    if (bash_pid <= 0)
     {
-        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
-        return;
+        fprintf(stderr, "Cannot locate current bash ancestor process.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ProcList descendants = {0};
+    if (collect_descendants(snap, bash_pid, &descendants) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of bash process %d\n", (int)bash_pid);
+        return;
+    }
+
+    printf("%zu\n", descendants.count);
+    free_proc_list(&descendants);
+}
+
+/**
+ * -bop：统计所有打开的 bash 终端子树中的进程总数（去重，不含 bash 进程本身）。
+ * 实现思路：
+ * 1. 遍历快照，收集所有 bash 进程 PID
+ * 2. 对每个 bash PID 调用 collect_descendants 收集后代进程
+ * 3. 将后代 PID 合并到全局列表并去重
+ * 4. 输出去重后的总数量
+ */
+static void opt_bop(const Snapshot *snap)
+{
+    pid_t *bash_pids = NULL;
+    size_t bash_count = 0;
+
+    for (size_t i = 0; i < snap->count; i++)
+    {
+        if (!snap->procs[i].is_bash)
+            continue;
+
+        if (append_pid(&bash_pids, &bash_count, snap->procs[i].pid) != 0)
+        {
+            free(bash_pids);
+            die_perror("realloc");
+        }
+    }
+
+    pid_t *all_pids = NULL;
+    size_t all_count = 0;
+
+    for (size_t i = 0; i < bash_count; i++)
+    {
+        ProcList descendants = {0};
+        if (collect_descendants(snap, bash_pids[i], &descendants) != 0)
+        {
+            pid_t failed_bash_pid = bash_pids[i];
+            free_proc_list(&descendants);
+            free(all_pids);
+            free(bash_pids);
+            fprintf(stderr, "Cannot collect descendants of bash process %d\n", (int)failed_bash_pid);
+            return;
+        }
+
+        for (size_t j = 0; j < descendants.count; j++)
+        {
+            pid_t pid = descendants.proc_items[j].pid;
+            if (pid_in_list(pid, all_pids, all_count)) // 去重
+                continue;
+
+            if (append_pid(&all_pids, &all_count, pid) != 0)
+            {
+                free_proc_list(&descendants);
+                free(all_pids);
+                free(bash_pids);
+                die_perror("realloc");
+            }
+        }
+
+        free_proc_list(&descendants);
+    }
+
+    printf("%zu\n", all_count);
+    free(all_pids);
+    free(bash_pids);
+}
+
+/**
+ * 默认功能（无选项）：判断 process_id 是否属于以 root_process 为根的子树。
+ * 实现思路：
+ * 1. 用快照中的 Euler 时间戳判断：process_id 的 [进入, 离开] 区间落在 root_process 的区间之内即属于该子树
+ * 2. 若属于，则输出 "process_id root_process"
+ * 3. 否则输出不属于该子树的提示信息并返回失败
+ */
+static int opt_default(const Snapshot *snap, pid_t process_id, pid_t root_process)
+{
+    if (snapshot_in_subtree(snap, process_id, root_process))
+    {
+        printf("%d %d\n", (int)process_id, (int)root_process);
+        return 0;
+    }
+
+    printf("Process %d does not belong to the process subtree rooted at %d\n",
+           (int)process_id, (int)root_process);
+    return -1;
+}
+
+/**
+ * -cnt：统计 process_id 的后代总数。
+ * 实现思路：后代个数直接由 Euler 时间戳算出：(euler_out - euler_in) / 2，不需要遍历子树
+ */
+static void opt_cnt(const Snapshot *snap, pid_t process_id)
+{
+    size_t idx = snapshot_index(snap, process_id);
+    printf("%zu\n", (idx == (size_t)-1) ? (size_t)0 : snapshot_descendant_count(snap, idx));
+}
+
+/**
+ * -oct：统计 process_id 的后代中孤儿进程的数量。
+ * 实现思路：
+ * 1. 用 collect_descendants(snap, process_id, &subtree_procs) 收集所有后代
+ * 2. 遍历每个后代，读取其当前父进程 pid
+ * 3. 排除直接子进程（parent == process_id）
+ * 4. 若父进程是 1，或父进程已不在该子树中（Euler 时间戳比较），则计为孤儿并累加
+ */
+static void opt_oct(const Snapshot *snap, pid_t process_id)
+{
+    ProcList subtree_procs = {0};
+    if (collect_descendants(snap, process_id, &subtree_procs) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+        return;
+    }
+
+    long orphan_count = 0;
+    for (size_t i = 0; i < subtree_procs.count; i++)
+    {
+        pid_t parent = subtree_procs.proc_items[i].ppid;
+        if (parent <= 0)
+            continue;
+
+        if (parent == process_id)
+            continue;
+
+        if (parent == 1 || !snapshot_in_subtree(snap, parent, process_id))
+            orphan_count++;
+    }
+
+    free_proc_list(&subtree_procs);
+    printf("%ld\n", orphan_count);
+}
+
+/**
+ * -dtm：向 process_id 的所有后代发送 SIGKILL 信号并终止，按创建时间从晚到早执行。
+ * 实现思路：
+ * 1. 交给 kill 引擎：先用 pidfd 锁定并 SIGSTOP 冻结整棵子树，防止一边杀一边 fork 出新进程
+ * 2. 通过 pidfd_send_signal 发送 SIGKILL，晚创建的先处理
+ * 3. 重新扫描直到子树中没有活着的后代，在 stderr 报告用了几轮
+ * 4. 跳过 bash 进程
+ */
+static void opt_dtm(const Snapshot *snap, pid_t process_id, int scan_threads)
+{
+    kill_subtree(snap, process_id, KILL_DESCENDANTS, scan_threads);
+}
+
+/**
+ * -odt：找出 process_id 后代中最早创建的进程并输出其 PID 与创建时间。
+ * 实现思路：
+ * 1. 用 collect_descendants(snap, process_id, &descendants) 收集所有后代
+ * 2. 遍历找到 start_ticks 最小的后代；若并列则取 PID 更小者
+ * 3. 结合系统 btime 与时钟频率将 start_ticks 转换为可读时间字符串
+ * 4. 按指定格式输出最老后代 PID 与创建时间
+ */
+static void opt_odt(const Snapshot *snap, pid_t process_id)
+{
+    ProcList descendants = {0};
+    if (collect_descendants(snap, process_id, &descendants) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+        return;
+    }
+
+    if (descendants.count == 0)
+    {
+        free_proc_list(&descendants);
+        return;
+    }
+
+    size_t oldest_idx = (size_t)-1;
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        if (descendants.proc_items[i].start_ticks < 0)
+            continue;
+
+        if (oldest_idx == (size_t)-1)
+        {
+            oldest_idx = i;
+            continue;
+        }
+
+        if (descendants.proc_items[i].start_ticks < descendants.proc_items[oldest_idx].start_ticks)
+            oldest_idx = i;
+        else if (descendants.proc_items[i].start_ticks == descendants.proc_items[oldest_idx].start_ticks &&
+                 descendants.proc_items[i].pid < descendants.proc_items[oldest_idx].pid)
+            oldest_idx = i;
+    }
+
+    if (oldest_idx != (size_t)-1)
+    {
+        time_t boot_time = 0;
+        long clk_tck = sysconf(_SC_CLK_TCK);
+        char time_buf[128] = "unknown";
+
+        if (clk_tck > 0 && read_boot_time_epoch(&boot_time) == 0)
+        {
+            time_t creation_time = boot_time +
+                                   (time_t)(descendants.proc_items[oldest_idx].start_ticks / clk_tck);
+            struct tm tm_local;
+            if (localtime_r(&creation_time, &tm_local) != NULL)
+            {
+                if (strftime(time_buf, sizeof(time_buf), "%a %d %b %Y %I:%M:%S %p %Z", &tm_local) == 0)
+                    strcpy(time_buf, "unknown");
+            }
+        }
+
+        printf("Oldest descendant of %d is %d, whose creation time is %s\n",
+               (int)process_id,
+               (int)descendants.proc_items[oldest_idx].pid,
+               time_buf);
+    }
+
+    free_proc_list(&descendants);
+}
+
+/**
+ * -ndt：找出 process_id 后代中最新创建的进程并输出其 PID。
+ * 实现思路：
+ * 1. 用 collect_descendants(snap, process_id, &descendants) 收集所有后代
+ * 2. 遍历找到 start_ticks 最大的后代；若并列则取 PID 更小者
+ * 3. 输出该后代 PID
+ */
+static void opt_ndt(const Snapshot *snap, pid_t process_id)
+{
+    ProcList descendants = {0};
+    if (collect_descendants(snap, process_id, &descendants) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+        return;
+    }
+
+    if (descendants.count == 0)
+    {
+        free_proc_list(&descendants);
+        return;
+    }
+
+    size_t newest_idx = (size_t)-1;
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        if (descendants.proc_items[i].start_ticks < 0)
+            continue;
+
+        if (newest_idx == (size_t)-1)
+        {
+            newest_idx = i;
+            continue;
+        }
+
+        if (descendants.proc_items[i].start_ticks > descendants.proc_items[newest_idx].start_ticks)
+            newest_idx = i;
+        else if (descendants.proc_items[i].start_ticks == descendants.proc_items[newest_idx].start_ticks &&
+                 descendants.proc_items[i].pid < descendants.proc_items[newest_idx].pid)
+            newest_idx = i;
+    }
+
+    if (newest_idx != (size_t)-1)
+        printf("%d\n", (int)descendants.proc_items[newest_idx].pid);
+
+    free_proc_list(&descendants);
+}
+
+/**
+ * -dnd：统计 process_id 的非直接后代数量（即后代总数减去直接子进程数）。
+ * 实现思路：
+ * 1. 后代总数由 Euler 时间戳算出
+ * 2. 直接子进程数取自邻接表
+ * 3. 输出两者之差
+ */
+static void opt_dnd(const Snapshot *snap, pid_t process_id)
+{
+    size_t idx = snapshot_index(snap, process_id);
+    if (idx == (size_t)-1)
+    {
+        printf("0\n");
+        return;
+    }
+
+    size_t direct_children_count = snap->child_start[idx + 1] - snap->child_start[idx];
+    printf("%zu\n", snapshot_descendant_count(snap, idx) - direct_children_count);
+}
+
+/**
+ * -sst：向 process_id 的所有兄弟进程发送 SIGSTOP 信号，要求它们暂停。
+ * 实现思路：
+ * 1. 复用 collect_siblings(snap, process_id, &siblings) 收集兄弟进程
+ * 2. 跳过 bash 进程，避免影响用户 shell
+ * 3. 对其余兄弟进程发送 SIGSTOP
+ */
+static void opt_sst(const Snapshot *snap, pid_t process_id)
+{
+    ProcList siblings = {0};
+    if (collect_siblings(snap, process_id, &siblings) != 0)
+    {
+        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
+        return;
+    }
+
+    for (size_t i = 0; i < siblings.count; i++)
+    {
+        pid_t pid = siblings.proc_items[i].pid;
+        if (siblings.proc_items[i].is_bash)
+        {
+            fprintf(stderr, "Process %d is BASH and will not be stopped\n", (int)pid);
+            continue;
+        }
+
+        if (kill(pid, SIGSTOP) != 0)
+        {
+            if (errno == ESRCH)
+                continue;
+
+            fprintf(stderr, "Failed to stop %d: %s\n", (int)pid, strerror(errno));
+        }
+    }
+
+    free_proc_list(&siblings);
+}
+
+/**
+ * -sco：向 process_id 的所有已暂停兄弟进程发送 SIGCONT 信号，要求它们继续执行。
+ * 实现思路：
+ * 1. 复用 collect_siblings(snap, process_id, &siblings) 收集兄弟进程
+ * 2. 跳过 bash 进程，避免影响用户 shell
+ * 3. 仅对状态为 T（stopped）的兄弟进程发送 SIGCONT
+ */
+static void opt_sco(const Snapshot *snap, pid_t process_id)
+{
+    ProcList siblings = {0};
+    if (collect_siblings(snap, process_id, &siblings) != 0)
+    {
+        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
+        return;
+    }
+
+    for (size_t i = 0; i < siblings.count; i++)
+    {
+        pid_t pid = siblings.proc_items[i].pid;
+
+        if (siblings.proc_items[i].is_bash)
+        {
+            fprintf(stderr, "Process %d is BASH and will not be continued\n", (int)pid);
+            continue;
+        }
+
+        if (siblings.proc_items[i].state != 'T')
+            continue;
+
+        if (kill(pid, SIGCONT) != 0)
+        {
+            if (errno == ESRCH)
+                continue;
+
+            fprintf(stderr, "Failed to continue %d: %s\n", (int)pid, strerror(errno));
+        }
+    }
+
+    free_proc_list(&siblings);
+}
+
+/**
+ * -kgp：向 process_id 的祖父进程发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 先读取 process_id 的父进程 PPID，记为 parent_pid
+ * 2. 再读取 parent_pid 的父进程 PPID，记为 grandparent_pid
+ * 3. 如果 grandparent_pid 不存在或者不大于 1，则不执行终止
+ * 4. 如果 grandparent_pid 是 bash 进程，则不执行终止
+ * 5. 否则，向 grandparent_pid 发送 SIGKILL 信号
+ */
+static void opt_kgp(const Snapshot *snap, pid_t process_id)
+{
+    pid_t parent_pid = -1;
+    if (snapshot_ppid(snap, process_id, &parent_pid) != 0 || parent_pid <= 0)
+    {
+        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
+        return;
+    }
+
+    pid_t grandparent_pid = -1;
+    if (snapshot_ppid(snap, parent_pid, &grandparent_pid) != 0 || grandparent_pid <= 0)
+    {
+        fprintf(stderr, "Cannot determine grandparent process of %d\n", (int)process_id);
+        return;
+    }
+
+    if (grandparent_pid <= 1) // 为系统进程，不能杀死
+    {
+        fprintf(stderr, "Grandparent is not a user process and will not be terminated\n");
+        return;
+    }
+
+    if (snapshot_is_bash(snap, grandparent_pid))
+    {
+        fprintf(stderr, "Grandparent is BASH and will not be terminated\n");
+        return;
+    }
+
+    if (kill(grandparent_pid, SIGKILL) != 0)
+    {
+        if (errno == ESRCH)
+        {
+            fprintf(stderr, "Grandparent process %d no longer exists\n", (int)grandparent_pid);
+            return;
+        }
+
+        fprintf(stderr, "Failed to kill grandparent %d: %s\n", (int)grandparent_pid, strerror(errno));
+        return;
+    }
+
+    printf("SIGKILL was sent to process %d\n", (int)grandparent_pid);
+}
+
+/**
+ * -kpp：向 process_id 的父进程发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 先读取 process_id 的父进程 PPID，记为 parent_pid
+ * 2. 如果 parent_pid 不存在或者不大于 1，就说明 process_id 没有父进程或者父进程是 init 进程了，这时不杀死 parent_pid
+ * 3. 如果 parent_pid 是 bash 进程，就不杀死 parent_pid
+ * 4. 否则，向 parent_pid 发送 SIGKILL 信号
+ */
+static void opt_kpp(const Snapshot *snap, pid_t process_id)
+{
+    pid_t parent_pid = -1;
+    if (snapshot_ppid(snap, process_id, &parent_pid) != 0 || parent_pid <= 0)
+    {
+        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
+        return;
+    }
+
+    if (parent_pid <= 1)
+    {
+        fprintf(stderr, "Parent is not a user process and will not be terminated\n");
+        return;
+    }
+
+    if (snapshot_is_bash(snap, parent_pid))
+    {
+        fprintf(stderr, "Parent is BASH and will not be terminated\n");
+        return;
+    }
+
+    if (kill(parent_pid, SIGKILL) != 0)
+    {
+        if (errno == ESRCH)
+        {
+            fprintf(stderr, "Parent process %d no longer exists\n", (int)parent_pid);
+            return;
+        }
+
+        fprintf(stderr, "Failed to kill parent %d: %s\n", (int)parent_pid, strerror(errno));
+        return;
+    }
+
+    printf("SIGKILL was sent to process %d\n", (int)parent_pid);
+}
+
+/**
+ * -ksp：向 process_id 的所有兄弟进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 复用 collect_siblings(snap, process_id, &siblings) 收集兄弟进程
+ * 2. 对每个 sibling 发送 SIGKILL
+ * 3. 遵守保护规则：bash sibling 不终止并提示
+ * 4. 错误处理：ESRCH 忽略，其它错误打印原因
+ */
+static void opt_ksp(const Snapshot *snap, pid_t process_id)
+{
+    ProcList siblings = {0};
+    if (collect_siblings(snap, process_id, &siblings) != 0)
+    {
+        fprintf(stderr, "Cannot determine siblings of process %d\n", (int)process_id);
+        return;
+    }
+
+    for (size_t i = 0; i < siblings.count; i++)
+    {
+        pid_t pid = siblings.proc_items[i].pid;
+
+        if (siblings.proc_items[i].is_bash)
+        {
+            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)pid);
+            continue;
+        }
+
+        if (kill(pid, SIGKILL) != 0)
+        {
+            if (errno == ESRCH)
+                continue;
+
+            fprintf(stderr, "Failed to kill sibling %d: %s\n", (int)pid, strerror(errno));
+        }
+    }
+
+    free_proc_list(&siblings);
+}
+
+/**
+ * -kps：向 process_id 的父进程的所有兄弟进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程，以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 先读取 process_id 的父进程 parent_pid
+ * 2. 复用 collect_siblings(snap, parent_pid, &parent_siblings) 获取“父进程的 siblings（叔伯）”
+ * 3. 对这些进程发送 SIGKILL
+ */
+static void opt_kps(const Snapshot *snap, pid_t process_id)
+{
+    pid_t parent_pid = -1;
+    if (snapshot_ppid(snap, process_id, &parent_pid) != 0 || parent_pid <= 0)
+    {
+        fprintf(stderr, "Cannot determine parent process of %d\n", (int)process_id);
+        return;
+    }
+
+    ProcList parent_siblings = {0};
+    if (collect_siblings(snap, parent_pid, &parent_siblings) != 0)
+    {
+        fprintf(stderr, "Cannot determine siblings of parent process %d\n", (int)parent_pid);
+        return;
+    }
+
+    for (size_t i = 0; i < parent_siblings.count; i++)
+    {
+        pid_t pid = parent_siblings.proc_items[i].pid;
+
+        if (parent_siblings.proc_items[i].is_bash)
+        {
+            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)pid);
+            continue;
+        }
+
+        if (kill(pid, SIGKILL) != 0)
+        {
+            if (errno == ESRCH)
+                continue;
+
+            fprintf(stderr, "Failed to kill parent sibling %d: %s\n", (int)pid, strerror(errno));
+        }
+    }
+
+    free_proc_list(&parent_siblings);
+}
+
+/**
+ * -kgc：向 process_id 的所有孙子进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程（即使 bash 进程是 process_id 的子进程），以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 从快照中沿邻接表取 子进程 的 子进程（即 grandchildren）
+ * 2. 交给 kill 引擎冻结、终止，并重新扫描直到没有活着的孙子进程
+ */
+static void opt_kgc(const Snapshot *snap, pid_t process_id, int scan_threads)
+{
+    kill_subtree(snap, process_id, KILL_GRANDCHILDREN, scan_threads);
+}
+
+/**
+ * -kcp：向 process_id 的所有子进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程（即使 bash 进程是 process_id 的子进程），以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 从快照中取 process_id 的直接子进程
+ * 2. 交给 kill 引擎冻结、终止，并重新扫描直到没有活着的子进程
+ */
+static void opt_kcp(const Snapshot *snap, pid_t process_id, int scan_threads)
+{
+    kill_subtree(snap, process_id, KILL_CHILDREN, scan_threads);
+}
+
+/**
+ * -krp：向 root_process 发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程（即使 bash 进程是 root_process），以免影响用户的正常操作。
+ * 实现思路：
+ * 1. 如果 root_process 不存在或者不大于 1，就说明 root_process 没有父进程或者父进程是 init 进程了，这时不杀死 root_process
+ * 2. 如果 root_process 是 bash 进程，就不杀死 root_process
+ * 3. 否则，通过 pidfd 向 root_process 发送 SIGKILL 信号（先核对 starttime，防止 pid 已被复用）
+ */
+static void opt_krp(const Snapshot *snap, pid_t root_process)
+{
+    if (root_process <= 1)
+    {
+        fprintf(stderr, "Root process is not a user process and will not be terminated\n");
+        return;
+    }
+
+    const Proc *root = snapshot_find(snap, root_process);
+    if (root && root->is_bash)
+    {
+        fprintf(stderr, "Root process is BASH and will not be terminated\n");
+        return;
+    }
+
+    /* 通过 pidfd 发信号，保证收到 SIGKILL 的就是快照中的那个进程，而不是复用了同一 pid 的新进程 */
+    int pidfd = root ? pidfd_open_verified(root) : -1;
+    if (pidfd == -1)
+    {
+        fprintf(stderr, "Root process %d no longer exists\n", (int)root_process);
+        return;
+    }
+
+    int rc = (pidfd >= 0) ? sys_pidfd_send_signal(pidfd, SIGKILL) : kill(root_process, SIGKILL);
+    close_if_open(pidfd);
+    if (rc != 0)
+    {
+        if (errno == ESRCH)
+        {
+            fprintf(stderr, "Root process %d no longer exists\n", (int)root_process);
+            return;
+        }
+
+        fprintf(stderr, "Failed to kill root process %d: %s\n", (int)root_process, strerror(errno));
+        return;
+    }
+
+    printf("SIGKILL was sent to process %d\n", (int)root_process);
+}
+
+/**
+ * -mmd：列出 process_id 的后代中占用内存最多的进程（VmRSS 最大）以及该 VmRSS 值。
+ * 实现思路：
+ * 1. 先用 collect_descendants(snap, process_id, &descendants) 收集后代
+ * 2. 遍历 descendants，找出最大 vmrss_bytes
+ * 3. 再遍历一次，输出所有 vmrss_bytes 等于最大值的后代（处理并列）
+ * 4. 输出最大 VmRSS（bytes）
+ */
+static void opt_mmd(const Snapshot *snap, pid_t process_id)
+{
+    ProcList descendants = {0};
+    if (collect_descendants(snap, process_id, &descendants) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+        return;
+    }
+
+    if (descendants.count == 0)
+    {
+        free_proc_list(&descendants);
+        return;
+    }
+
+    long long max_vmrss = -1;
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        if (descendants.proc_items[i].vmrss_bytes > max_vmrss)
+            max_vmrss = descendants.proc_items[i].vmrss_bytes;
+    }
+
+    if (max_vmrss < 0)
+    {
+        fprintf(stderr, "No VmRSS information available for descendants of %d\n", (int)process_id);
+        free_proc_list(&descendants);
+        return;
+    }
+
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        if (descendants.proc_items[i].vmrss_bytes == max_vmrss)
+        {
+            printf("%d is the descendant of %d consuming the most memory.\n",
+                   (int)descendants.proc_items[i].pid,
+                   (int)process_id);
+        }
+    }
+    printf("VmRSS: %lld bytes\n", max_vmrss);
+
+    free_proc_list(&descendants);
+}
+
+/**
+ * -mpd：列出 process_id 的后代中累计 CPU 时间最多的进程（utime+stime 最大），并输出该累计时钟 tick 值。
+ * 实现思路：
+ * 1. 先用 collect_descendants(snap, process_id, &descendants) 收集后代
+ * 2. 对每个后代计算 cpu_ticks = utime_ticks + stime_ticks，找出最大值
+ * 3. 再遍历一次，输出所有 cpu_ticks 等于最大值的后代（处理并列）
+ * 4. 输出最大累计 CPU 时间（clock ticks）
+ */
+static void opt_mpd(const Snapshot *snap, pid_t process_id)
+{
+    ProcList descendants = {0};
+    if (collect_descendants(snap, process_id, &descendants) != 0)
+    {
+        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
+        return;
+    }
+
+    if (descendants.count == 0)
+    {
+        free_proc_list(&descendants);
+        return;
+    }
+
+    unsigned long long max_cpu_ticks = 0;
+    int found = 0;
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        unsigned long long cpu_ticks =
+            (unsigned long long)descendants.proc_items[i].utime_ticks +
+            (unsigned long long)descendants.proc_items[i].stime_ticks;
+        if (!found || cpu_ticks > max_cpu_ticks)
+        {
+            max_cpu_ticks = cpu_ticks;
+            found = 1;
+        }
+    }
+
+    for (size_t i = 0; i < descendants.count; i++)
+    {
+        unsigned long long cpu_ticks =
+            (unsigned long long)descendants.proc_items[i].utime_ticks +
+            (unsigned long long)descendants.proc_items[i].stime_ticks;
+        if (cpu_ticks == max_cpu_ticks)
+        {
+            printf("%d is the descendant of %d that has used the most CPU time.\n",
+                   (int)descendants.proc_items[i].pid,
+                   (int)process_id);
+        }
+    }
+    printf("Total CPU time: %llu clock ticks\n", max_cpu_ticks);
+
+    free_proc_list(&descendants);
+}
+
+/* 每隔多少次采样做一次完整的 /proc 快照来校正子树成员（children 文件只列出主线程 fork 的子进程） */
+#define SAMPLER_RESYNC_TICKS 10
+
+/* 用途：watch 模式中持续跟踪的一个进程。stat/statm/children 的文件描述符在两次采样之间保持打开，用 pread 重读。 */
+typedef struct TrackedProc
+{
+    Proc info;                /* 最近一次采样的结果 */
+    int stat_fd;              /* -1 表示没能保持打开（例如 fd 用尽），每次按路径重新读取 */
+    int statm_fd;
+    int children_fd;          /* /proc/<pid>/task/<pid>/children */
+    long long prev_cpu_ticks; /* 上一次采样的 utime+stime，新出现的进程为 -1 */
+    long long cpu_delta;      /* 两次采样之间消耗的 clock ticks */
+    long long prev_rss;       /* 上一次采样的 RSS（bytes） */
+    long long first_rss;      /* 第一次采样到的 RSS（bytes），用于计算趋势 */
+    int seen;                 /* 本轮采样中是否仍属于子树 */
+} TrackedProc;
+
+/* 用途：watch 模式的增量采样器，只跟踪 root_pid 子树中的进程。 */
+typedef struct Sampler
+{
+    pid_t root_pid;
+    int root_children_fd;   /* -1 表示系统不提供 children 文件，每轮都用完整快照 */
+    TrackedProc *items;
+    size_t count;
+    size_t cap;
+    PidIndex index;         /* pid → items 下标 */
+    pid_t *queue;           /* 广度优先遍历用的 pid 队列 */
+    size_t queue_cap;
+    double last_time;       /* 上一次采样的时间（CLOCK_MONOTONIC 秒） */
+    double elapsed;         /* 最近两次采样的间隔（秒） */
+    unsigned long ticks;
+} Sampler;
+
+static volatile sig_atomic_t watch_stop = 0;
+
+static void watch_on_signal(int sig)
+{
+    (void)sig;
+    watch_stop = 1;
+}
+
+static int open_proc_file(pid_t pid, const char *leaf)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, leaf);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static int open_children_file(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)pid, (int)pid);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * 用途：读取 pid 的某个 /proc 文件：fd 有效时用 pread 从头重读，否则按路径打开读取后关闭。
+ */
+static ssize_t tracked_read(int fd, pid_t pid, const char *leaf, char *buf, size_t size)
+{
+    if (fd >= 0)
+    {
+        ssize_t n = pread(fd, buf, size - 1, 0);
+        if (n < 0)
+            return -1;
+        buf[n] = '\0';
+        return n;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, leaf);
+    return read_small_file(path, buf, size);
+}
+
+static void tracked_close(TrackedProc *item)
+{
+    close_if_open(item->stat_fd);
+    close_if_open(item->statm_fd);
+    close_if_open(item->children_fd);
+    item->stat_fd = item->statm_fd = item->children_fd = -1;
+}
+
+static int queue_push(Sampler *sampler, size_t *queue_len, pid_t pid)
+{
+    if (*queue_len == sampler->queue_cap)
+    {
+        size_t new_cap = (sampler->queue_cap == 0) ? 256 : sampler->queue_cap * 2;
+        pid_t *new_queue = realloc(sampler->queue, new_cap * sizeof(*new_queue));
+        if (!new_queue)
+            return -1;
+        sampler->queue = new_queue;
+        sampler->queue_cap = new_cap;
+    }
+    sampler->queue[(*queue_len)++] = pid;
+    return 0;
+}
+
+/**
+ * 用途：用 pread 分块读取 children 文件（内容是空格分隔的子进程 pid），把子进程追加到遍历队列。
+ * 返回 -1 表示文件读不出来（进程已退出或系统不支持）。
+ */
+static int read_children_into_queue(Sampler *sampler, int fd, size_t *queue_len)
+{
+    char buf[PROC_READ_BUF_SIZE];
+    off_t offset = 0;
+    long long partial = 0;
+    int in_number = 0;
+
+    while (1)
+    {
+        ssize_t n = pread(fd, buf, sizeof(buf), offset);
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (buf[i] >= '0' && buf[i] <= '9')
+            {
+                partial = partial * 10 + (buf[i] - '0');
+                in_number = 1;
+            }
+            else if (in_number)
+            {
+                if (queue_push(sampler, queue_len, (pid_t)partial) != 0)
+                    return -1;
+                partial = 0;
+                in_number = 0;
+            }
+        }
+        offset += n;
+    }
+
+    if (in_number && queue_push(sampler, queue_len, (pid_t)partial) != 0)
+        return -1;
+    return 0;
+}
+
+/**
+ * 用途：确保 pid 在跟踪表中（新进程会打开 stat/statm/children 的 fd），并标记为本轮仍在子树中。
+ * 返回该进程在 items 中的下标；失败返回 (size_t)-1。
+ */
+static size_t sampler_track(Sampler *sampler, pid_t pid)
+{
+    size_t idx = pid_index_get(&sampler->index, pid);
+    if (idx != (size_t)-1)
+    {
+        sampler->items[idx].seen = 1;
+        return idx;
+    }
+
+    if (sampler->count == sampler->cap)
+    {
+        size_t new_cap = (sampler->cap == 0) ? 256 : sampler->cap * 2;
+        TrackedProc *new_items = realloc(sampler->items, new_cap * sizeof(*new_items));
+        if (!new_items)
+            return (size_t)-1;
+        sampler->items = new_items;
+        sampler->cap = new_cap;
+    }
+
+    TrackedProc *item = &sampler->items[sampler->count];
+    memset(item, 0, sizeof(*item));
+    item->info.pid = pid;
+    item->stat_fd = open_proc_file(pid, "stat");
+    item->statm_fd = open_proc_file(pid, "statm");
+    item->children_fd = open_children_file(pid);
+    item->prev_cpu_ticks = -1;
+    item->prev_rss = -1;
+    item->first_rss = -1;
+    item->seen = 1;
+
+    if (pid_index_put(&sampler->index, pid, sampler->count) != 0)
+    {
+        tracked_close(item);
+        return (size_t)-1;
+    }
+    return sampler->count++;
+}
+
+/**
+ * 用途：关闭本轮不再属于子树（或已退出）的进程的 fd，压缩跟踪表并重建 pid 索引。
+ */
+static void sampler_compact(Sampler *sampler)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < sampler->count; i++)
+    {
+        if (!sampler->items[i].seen)
+        {
+            tracked_close(&sampler->items[i]);
+            continue;
+        }
+        sampler->items[kept++] = sampler->items[i];
+    }
+    sampler->count = kept;
+
+    pid_index_clear(&sampler->index);
+    for (size_t i = 0; i < sampler->count; i++)
+        pid_index_put(&sampler->index, sampler->items[i].info.pid, i);
+}
+
+/**
+ * 用途：重新读取一个被跟踪进程的 stat/statm，计算 CPU ticks 增量与 RSS 变化。
+ * 返回 -1 表示进程已退出（fd 绑定的是原来的进程，pid 被复用时 pread 同样会失败）。
+ */
+static int sampler_refresh(TrackedProc *item)
+{
+    char buf[PROC_READ_BUF_SIZE];
+    pid_t pid = item->info.pid;
+    long long old_start = item->info.start_ticks;
+
+    ssize_t len = tracked_read(item->stat_fd, pid, "stat", buf, sizeof(buf));
+    if (len <= 0)
+        return -1;
+
+    Proc fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.pid = pid;
+    fresh.ppid = -1;
+    fresh.start_ticks = -1;
+    fresh.vmrss_bytes = -1;
+    if (parse_proc_stat(buf, (size_t)len, &fresh) != 0)
+        return -1;
+    fresh.is_bash = (strcmp(fresh.name, "bash") == 0);
+
+    /* 没有保持 fd 时按路径读取，starttime 变化说明 pid 已被新进程复用 */
+    if (item->prev_cpu_ticks >= 0 && fresh.start_ticks != old_start)
+    {
+        item->prev_cpu_ticks = -1;
+        item->prev_rss = -1;
+        item->first_rss = -1;
+    }
+
+    len = tracked_read(item->statm_fd, pid, "statm", buf, sizeof(buf));
+    if (len > 0)
+        fresh.vmrss_bytes = parse_proc_statm(buf, (size_t)len);
+
+    long long cpu_ticks = (long long)fresh.utime_ticks + (long long)fresh.stime_ticks;
+    item->cpu_delta = (item->prev_cpu_ticks >= 0) ? cpu_ticks - item->prev_cpu_ticks : 0;
+    item->prev_cpu_ticks = cpu_ticks;
+
+    if (item->first_rss < 0)
+        item->first_rss = fresh.vmrss_bytes;
+    item->prev_rss = (item->prev_rss < 0) ? fresh.vmrss_bytes : item->info.vmrss_bytes;
+    item->info = fresh;
+    return 0;
+}
+
+static void free_sampler(Sampler *sampler)
+{
+    for (size_t i = 0; i < sampler->count; i++)
+        tracked_close(&sampler->items[i]);
+    close_if_open(sampler->root_children_fd);
+    free(sampler->items);
+    free(sampler->queue);
+    pid_index_free(&sampler->index);
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->root_children_fd = -1;
+}
+
+static void init_sampler(Sampler *sampler, pid_t root_pid)
+{
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->root_pid = root_pid;
+    sampler->root_children_fd = open_children_file(root_pid);
+    sampler->last_time = monotonic_seconds();
+}
+
+/**
+ * 用途：采样一次 root_pid 的子树。
+ * 实现思路：
+ * 1. 成员发现：平时从 root 开始沿已打开的 children fd 做广度优先遍历，只为新出现的 pid 打开 fd；
+ *    resync 不为 NULL 时（第一次、每 SAMPLER_RESYNC_TICKS 次、或系统没有 children 文件），改用完整快照中的后代集合
+ * 2. 关闭不再属于子树的进程的 fd，压缩跟踪表
+ * 3. 对每个进程 pread 一次 stat 和 statm，计算 CPU 增量与 RSS 变化；读不到的视为已退出并移除
+ * 返回 -1 表示 root_pid 已经不存在。
+ */
+static int sampler_tick(Sampler *sampler, const Snapshot *resync)
+{
+    double now = monotonic_seconds();
+    sampler->elapsed = now - sampler->last_time;
+    sampler->last_time = now;
+    sampler->ticks++;
+
+    for (size_t i = 0; i < sampler->count; i++)
+        sampler->items[i].seen = 0;
+
+    if (resync)
+    {
+        if (!snapshot_find(resync, sampler->root_pid))
+            return -1;
+
+        ProcList descendants = {0};
+        if (collect_descendants(resync, sampler->root_pid, &descendants) != 0)
+            return -1;
+        for (size_t i = 0; i < descendants.count; i++)
+            sampler_track(sampler, descendants.proc_items[i].pid);
+        free_proc_list(&descendants);
+    }
+    else
+    {
+        size_t queue_len = 0;
+        if (read_children_into_queue(sampler, sampler->root_children_fd, &queue_len) != 0)
+            return -1;
+
+        for (size_t head = 0; head < queue_len; head++)
+        {
+            pid_t pid = sampler->queue[head];
+            size_t idx = pid_index_get(&sampler->index, pid);
+            if (idx != (size_t)-1 && sampler->items[idx].seen) // 已经在本轮访问过
+                continue;
+
+            idx = sampler_track(sampler, pid);
+            if (idx == (size_t)-1 || sampler->items[idx].children_fd < 0)
+                continue;
+
+            read_children_into_queue(sampler, sampler->items[idx].children_fd, &queue_len);
+        }
+    }
+
+    for (size_t i = 0; i < sampler->count; i++)
+    {
+        if (sampler->items[i].seen && sampler_refresh(&sampler->items[i]) != 0)
+            sampler->items[i].seen = 0;
+    }
+    sampler_compact(sampler);
+    return 0;
+}
+
+/**
+ * 用途：判断本轮采样是否需要用完整快照来校正子树成员。
+ */
+static int sampler_needs_resync(const Sampler *sampler)
+{
+    return sampler->root_children_fd < 0 || sampler->ticks % SAMPLER_RESYNC_TICKS == 0;
+}
+
+static int cmp_tracked_cpu_desc(const void *a, const void *b)
+{
+    const TrackedProc *ea = *(const TrackedProc *const *)a;
+    const TrackedProc *eb = *(const TrackedProc *const *)b;
+
+    if (ea->cpu_delta != eb->cpu_delta)
+        return (ea->cpu_delta < eb->cpu_delta) ? 1 : -1;
+    if (ea->info.pid != eb->info.pid)
+        return (ea->info.pid < eb->info.pid) ? -1 : 1;
+    return 0;
+}
+
+static long long rss_kb(long long bytes)
+{
+    return (bytes < 0) ? 0 : bytes / 1024;
+}
+
+/**
+ * 用途：输出一次采样结果：子树汇总一行，然后按 CPU% 从高到低列出最多 max_lines 个后代。
+ * dRSS 为相对上一次采样的变化，trend 为相对第一次采样到该进程时的变化（KB）。
+ */
+static void print_watch_report(const Sampler *sampler, size_t max_lines)
+{
+    long clk_tck = sysconf(_SC_CLK_TCK);
+    double tick_scale = (clk_tck > 0 && sampler->elapsed > 0) ? 100.0 / ((double)clk_tck * sampler->elapsed) : 0.0;
+
+    const TrackedProc **order = malloc((sampler->count + 1) * sizeof(*order));
+    if (!order)
+        die_perror("malloc");
+
+    double total_cpu = 0;
+    long long total_rss = 0;
+    for (size_t i = 0; i < sampler->count; i++)
+    {
+        order[i] = &sampler->items[i];
+        total_cpu += (double)sampler->items[i].cpu_delta * tick_scale;
+        total_rss += rss_kb(sampler->items[i].info.vmrss_bytes);
+    }
+    qsort(order, sampler->count, sizeof(*order), cmp_tracked_cpu_desc);
+
+    char time_buf[32] = "";
+    time_t now = time(NULL);
+    struct tm tm_local;
+    if (localtime_r(&now, &tm_local))
+        strftime(time_buf, sizeof(time_buf), "%H:%M:%S", &tm_local);
+
+    printf("[%s] %d: %zu descendants, CPU %.1f%%, RSS %lld KB\n",
+           time_buf, (int)sampler->root_pid, sampler->count, total_cpu, total_rss);
+    printf("%8s %8s %s %7s %10s %9s %9s  %s\n", "PID", "PPID", "S", "CPU%", "RSS(KB)", "dRSS", "trend", "NAME");
+
+    for (size_t i = 0; i < sampler->count && i < max_lines; i++)
+    {
+        const TrackedProc *item = order[i];
+        long long rss = rss_kb(item->info.vmrss_bytes);
+        printf("%8d %8d %c %7.1f %10lld %+9lld %+9lld  %s\n",
+               (int)item->info.pid,
+               (int)item->info.ppid,
+               item->info.state ? item->info.state : '?',
+               (double)item->cpu_delta * tick_scale,
+               rss,
+               rss - rss_kb(item->prev_rss),
+               rss - rss_kb(item->first_rss),
+               item->info.name);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    free(order);
+}
+
+/**
+ * 用途：让当前线程睡眠 seconds 秒；被信号打断时提前返回。
+ */
+static void sleep_seconds(double seconds)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    while (!watch_stop && nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+/**
+ * -watch <interval> [lines]：持续监视 process_id 的子树，每 interval 秒输出一次各后代的 CPU% 与 RSS 变化，Ctrl-C 结束。
+ * 实现思路：
+ * 1. 第一次采样直接使用 main 中已经建立的快照确定子树成员
+ * 2. 之后每轮由 sampler_tick() 沿 children fd 增量发现成员，对已打开的 stat/statm fd 做 pread，
+ *    只在进程出现/退出时打开/关闭 fd，不再遍历整个 /proc
+ * 3. CPU% = 两次采样之间的 (utime+stime) 增量 / (CLK_TCK × 实际间隔)
+ */
+static void opt_watch(const Snapshot *snap, pid_t process_id, double interval, size_t max_lines, int scan_threads)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    raise_fd_limit();
+
+    Sampler sampler;
+    init_sampler(&sampler, process_id);
+    if (sampler_tick(&sampler, snap) != 0)
+    {
+        fprintf(stderr, "Cannot sample descendants of process %d\n", (int)process_id);
+        free_sampler(&sampler);
+        return;
+    }
+
+    while (!watch_stop)
+    {
+        sleep_seconds(interval);
+        if (watch_stop)
+            break;
+
+        int rc;
+        if (sampler_needs_resync(&sampler))
+        {
+            Snapshot resync;
+            if (snapshot_build(&resync, scan_threads) != 0)
+                die_perror("snapshot /proc");
+            rc = sampler_tick(&sampler, &resync);
+            free_snapshot(&resync);
+        }
+        else
+        {
+            rc = sampler_tick(&sampler, NULL);
+        }
+
+        if (rc != 0)
+        {
+            printf("Process %d has exited, stop watching.\n", (int)process_id);
+            break;
+        }
+        print_watch_report(&sampler, max_lines);
+    }
+
+    free_sampler(&sampler);
+}
+
+/* daemon 模式：没有 netlink 权限时的轮询间隔默认值（秒），以及 netlink 模式下的定期全量校正间隔（秒） */
+#define DAEMON_DEFAULT_POLL_SECONDS 1.0
+#define DAEMON_RESYNC_SECONDS 60.0
+
+/* 用途：daemon 模式中常驻内存的一个进程节点。子进程用双向链表串起来，增删都是 O(1)。 */
+typedef struct TreeNode
+{
+    pid_t pid;
+    pid_t ppid;
+    int is_bash;
+    int in_use;
+    size_t parent;       /* (size_t)-1 表示父进程不在树中 */
+    size_t first_child;
+    size_t next_sibling;
+    size_t prev_sibling;
+} TreeNode;
+
+/* 用途：增量维护的进程树。nodes 中空出的槽位放在 free_slots 中复用，index 为 pid → 槽位。 */
+typedef struct LiveTree
+{
+    TreeNode *nodes;
+    size_t count;
+    size_t cap;
+    size_t *free_slots;
+    size_t free_count;
+    PidIndex index;
+    size_t *stack; /* 子树遍历用的显式栈 */
+    size_t stack_cap;
+} LiveTree;
+
+static void free_live_tree(LiveTree *tree)
+{
+    free(tree->nodes);
+    free(tree->free_slots);
+    free(tree->stack);
+    pid_index_free(&tree->index);
+    memset(tree, 0, sizeof(*tree));
+}
+
+static void live_tree_unlink(LiveTree *tree, size_t slot)
+{
+    TreeNode *node = &tree->nodes[slot];
+    if (node->parent == (size_t)-1)
+        return;
+
+    if (node->prev_sibling != (size_t)-1)
+        tree->nodes[node->prev_sibling].next_sibling = node->next_sibling;
+    else
+        tree->nodes[node->parent].first_child = node->next_sibling;
+    if (node->next_sibling != (size_t)-1)
+        tree->nodes[node->next_sibling].prev_sibling = node->prev_sibling;
+
+    node->parent = node->next_sibling = node->prev_sibling = (size_t)-1;
+}
+
+/**
+ * 用途：把 slot 挂到 ppid 对应的节点下面（父进程不在树中时保持游离，等它出现或下一次校正）。
+ */
+static void live_tree_link(LiveTree *tree, size_t slot, pid_t ppid)
+{
+    live_tree_unlink(tree, slot);
+    tree->nodes[slot].ppid = ppid;
+
+    size_t parent = pid_index_get(&tree->index, ppid);
+    if (parent == (size_t)-1 || parent == slot)
+        return;
+
+    TreeNode *node = &tree->nodes[slot];
+    node->parent = parent;
+    node->prev_sibling = (size_t)-1;
+    node->next_sibling = tree->nodes[parent].first_child;
+    if (node->next_sibling != (size_t)-1)
+        tree->nodes[node->next_sibling].prev_sibling = slot;
+    tree->nodes[parent].first_child = slot;
+}
+
+/**
+ * 用途：新增一个节点（已存在时只更新父进程），返回槽位；失败返回 (size_t)-1。
+ */
+static size_t live_tree_add(LiveTree *tree, pid_t pid, pid_t ppid, int is_bash)
+{
+    size_t slot = pid_index_get(&tree->index, pid);
+    if (slot == (size_t)-1)
+    {
+        if (tree->free_count > 0)
+        {
+            slot = tree->free_slots[--tree->free_count];
+        }
+        else
+        {
+            if (tree->count == tree->cap)
+            {
+                size_t new_cap = (tree->cap == 0) ? 1024 : tree->cap * 2;
+                TreeNode *new_nodes = realloc(tree->nodes, new_cap * sizeof(*new_nodes));
+                size_t *new_free = realloc(tree->free_slots, new_cap * sizeof(*new_free));
+                if (new_nodes)
+                    tree->nodes = new_nodes;
+                if (new_free)
+                    tree->free_slots = new_free;
+                if (!new_nodes || !new_free)
+                    return (size_t)-1;
+                tree->cap = new_cap;
+            }
+            slot = tree->count++;
+        }
+
+        if (pid_index_put(&tree->index, pid, slot) != 0)
+        {
+            tree->free_slots[tree->free_count++] = slot;
+            return (size_t)-1;
+        }
+
+        TreeNode *node = &tree->nodes[slot];
+        memset(node, 0, sizeof(*node));
+        node->pid = pid;
+        node->in_use = 1;
+        node->parent = node->first_child = node->next_sibling = node->prev_sibling = (size_t)-1;
+    }
+
+    tree->nodes[slot].is_bash = is_bash;
+    if (tree->nodes[slot].parent == (size_t)-1 || tree->nodes[slot].ppid != ppid)
+        live_tree_link(tree, slot, ppid);
+    return slot;
+}
+
+/**
+ * 用途：删除一个已退出的进程。它的子进程已被内核改挂到 init 或 subreaper 下，
+ * 这里重新读取这些子进程的 ppid 并改挂（这是事件处理时的 I/O，查询时不需要）。
+ */
+static void live_tree_remove(LiveTree *tree, pid_t pid)
+{
+    size_t slot = pid_index_get(&tree->index, pid);
+    if (slot == (size_t)-1)
+        return;
+
+    live_tree_unlink(tree, slot);
+
+    size_t child = tree->nodes[slot].first_child;
+    while (child != (size_t)-1)
+    {
+        size_t next = tree->nodes[child].next_sibling;
+        tree->nodes[child].parent = tree->nodes[child].next_sibling = tree->nodes[child].prev_sibling = (size_t)-1;
+
+        Proc proc;
+        if (read_proc_info(tree->nodes[child].pid, &proc) == 0)
+            live_tree_link(tree, child, proc.ppid);
+        child = next;
+    }
+    tree->nodes[slot].first_child = (size_t)-1;
+
+    pid_index_remove(&tree->index, pid);
+    tree->nodes[slot].in_use = 0;
+    tree->free_slots[tree->free_count++] = slot;
+}
+
+/**
+ * 用途：用一份完整快照校正整棵树（diff-scan）：删除快照中已不存在的进程，补上新进程，改挂父进程变化的节点。
+ */
+static void live_tree_sync(LiveTree *tree, const Snapshot *snap)
+{
+    for (size_t slot = 0; slot < tree->count; slot++)
+    {
+        if (tree->nodes[slot].in_use && !snapshot_find(snap, tree->nodes[slot].pid))
+            live_tree_remove(tree, tree->nodes[slot].pid);
+    }
+
+    /* 先全部加入再挂父进程，避免子进程先于父进程出现时挂不上 */
+    for (size_t i = 0; i < snap->count; i++)
+        live_tree_add(tree, snap->procs[i].pid, -1, snap->procs[i].is_bash);
+    for (size_t i = 0; i < snap->count; i++)
+    {
+        size_t slot = pid_index_get(&tree->index, snap->procs[i].pid);
+        if (slot != (size_t)-1 && (tree->nodes[slot].parent == (size_t)-1 || tree->nodes[slot].ppid != snap->procs[i].ppid))
+            live_tree_link(tree, slot, snap->procs[i].ppid);
+    }
+}
+
+/**
+ * 用途：遍历 root 的子树（不含 root），统计后代数、直接子进程数和孤儿数（规则与 -oct 相同）。
+ * 只访问子树内的节点，不做任何 I/O。返回 -1 表示 root 不在树中。
+ */
+static int live_tree_subtree_stats(LiveTree *tree, pid_t root, size_t *total_out, size_t *direct_out, long *orphan_out)
+{
+    size_t root_slot = pid_index_get(&tree->index, root);
+    if (root_slot == (size_t)-1)
+        return -1;
+
+    size_t total = 0;
+    size_t direct = 0;
+    long orphans = 0;
+    size_t top = 0;
+
+    for (size_t child = tree->nodes[root_slot].first_child; child != (size_t)-1; child = tree->nodes[child].next_sibling)
+        direct++;
+
+    if (tree->stack_cap < tree->count + 1)
+    {
+        size_t *new_stack = realloc(tree->stack, (tree->count + 1) * sizeof(*new_stack));
+        if (!new_stack)
+            return -1;
+        tree->stack = new_stack;
+        tree->stack_cap = tree->count + 1;
+    }
+
+    tree->stack[top++] = root_slot;
+    while (top > 0)
+    {
+        size_t cur = tree->stack[--top];
+        for (size_t child = tree->nodes[cur].first_child; child != (size_t)-1; child = tree->nodes[child].next_sibling)
+        {
+            if (total == tree->count) // 防御：链表中出现环
+                break;
+            total++;
+            if (tree->nodes[child].ppid != root && tree->nodes[child].ppid == 1)
+                orphans++;
+            tree->stack[top++] = child;
+        }
+    }
+
+    *total_out = total;
+    *direct_out = direct;
+    *orphan_out = orphans;
+    return 0;
+}
+
+/**
+ * 用途：沿树中的父链判断 pid 是否属于以 root 为根的子树（与默认功能相同）。
+ */
+static int live_tree_in_subtree(const LiveTree *tree, pid_t pid, pid_t root)
+{
+    if (pid == root)
+        return 1;
+
+    size_t slot = pid_index_get(&tree->index, pid);
+    for (size_t steps = 0; slot != (size_t)-1 && steps < tree->count; steps++)
+    {
+        size_t parent = tree->nodes[slot].parent;
+        if (parent == (size_t)-1)
+            return 0;
+        if (tree->nodes[parent].pid == root)
+            return 1;
+        slot = parent;
+    }
+    return 0;
+}
+
+/**
+ * 用途：回答一行查询 "root_process process_id [-cnt|-oct|-dnd]"，输出与命令行逐行相同（先输出默认功能的结果）。
+ */
+static void daemon_answer(LiveTree *tree, char *line)
+{
+    char *saveptr = NULL;
+    char *root_text = strtok_r(line, " \t\r\n", &saveptr);
+    char *pid_text = strtok_r(NULL, " \t\r\n", &saveptr);
+    char *opt = strtok_r(NULL, " \t\r\n", &saveptr);
+    if (!root_text)
+        return;
+
+    char *end1 = NULL;
+    char *end2 = NULL;
+    long root = strtol(root_text, &end1, 10);
+    long pid = pid_text ? strtol(pid_text, &end2, 10) : 0;
+    if (!pid_text || *end1 != '\0' || *end2 != '\0' || root <= 0 || root > INT_MAX || pid <= 0 || pid > INT_MAX)
+    {
+        printf("ERR expected: root_process process_id [-cnt|-oct|-dnd]\n");
+        return;
+    }
+
+    if (!live_tree_in_subtree(tree, (pid_t)pid, (pid_t)root))
+    {
+        printf("Process %d does not belong to the process subtree rooted at %d\n", (int)pid, (int)root);
+        return;
+    }
+    printf("%d %d\n", (int)pid, (int)root);
+    if (!opt)
+        return;
+
+    /* 与命令行一致：进程不在树中时按空子树处理 */
+    size_t total = 0;
+    size_t direct = 0;
+    long orphans = 0;
+    live_tree_subtree_stats(tree, (pid_t)pid, &total, &direct, &orphans);
+
+    if (strcmp(opt, "-cnt") == 0)
+        printf("%zu\n", total);
+    else if (strcmp(opt, "-oct") == 0)
+        printf("%ld\n", orphans);
+    else if (strcmp(opt, "-dnd") == 0)
+        printf("%zu\n", total - direct);
+    else
+        printf("ERR unsupported option: %s\n", opt);
+}
+
+/**
+ * 用途：打开 netlink 进程连接器并订阅 fork/exec/exit 事件。需要 CAP_NET_ADMIN，失败返回 -1。
+ */
+static int proc_connector_open(void)
+{
+    int sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (sock < 0)
+        return -1;
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    addr.nl_pid = (unsigned int)getpid();
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(sock);
+        return -1;
     }
 
-    ProcList parent_siblings = {0};
-    if (collect_siblings(parent_pid, &parent_siblings) != 0)
+    struct
     {
-        fprintf(stderr, "Cannot determine siblings of parent process %d\n", (int)parent_pid);
-        return;
-    }
+        struct nlmsghdr hdr;
+        struct cn_msg msg;
+        enum proc_cn_mcast_op op;
+    } __attribute__((packed)) req;
 
-    for (size_t i = 0; i < parent_siblings.count; i++)
+    memset(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = sizeof(req);
+    req.hdr.nlmsg_type = NLMSG_DONE;
+    req.hdr.nlmsg_pid = (unsigned int)getpid();
+    req.msg.id.idx = CN_IDX_PROC;
+    req.msg.id.val = CN_VAL_PROC;
+    req.msg.len = sizeof(req.op);
+    req.op = PROC_CN_MCAST_LISTEN;
+
+    if (send(sock, &req, sizeof(req), 0) != (ssize_t)sizeof(req))
     {
-        pid_t pid = parent_siblings.proc_items[i].pid;
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
 
-        if (parent_siblings.proc_items[i].is_bash)
+/**
+ * 用途：读取并应用一批进程事件。返回 1 表示事件丢失（ENOBUFS），需要用完整快照校正；返回 -1 表示 socket 出错。
+ */
+static int proc_connector_drain(int sock, LiveTree *tree)
+{
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    while (1)
+    {
+        ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0)
         {
-            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)pid);
-            continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            if (errno == EINTR)
+                continue;
+            return (errno == ENOBUFS) ? 1 : -1;
         }
+        if (n == 0)
+            return -1;
 
-        if (kill(pid, SIGKILL) != 0)
+        for (struct nlmsghdr *hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, (unsigned int)n); hdr = NLMSG_NEXT(hdr, n))
         {
-            if (errno == ESRCH)
+            if (hdr->nlmsg_type == NLMSG_ERROR || hdr->nlmsg_type == NLMSG_NOOP)
                 continue;
 
-            fprintf(stderr, "Failed to kill parent sibling %d: %s\n", (int)pid, strerror(errno));
+            struct cn_msg *msg = NLMSG_DATA(hdr);
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC)
+                continue;
+
+            struct proc_event *ev = (struct proc_event *)msg->data;
+            if (ev->what == PROC_EVENT_FORK)
+            {
+                /* 线程创建也会产生 fork 事件，只关心新进程（pid == tgid） */
+                if (ev->event_data.fork.child_pid != ev->event_data.fork.child_tgid)
+                    continue;
+                size_t parent = pid_index_get(&tree->index, ev->event_data.fork.parent_tgid);
+                int is_bash = (parent != (size_t)-1) ? tree->nodes[parent].is_bash : 0; // fork 之后 comm 与父进程相同
+                live_tree_add(tree, ev->event_data.fork.child_tgid, ev->event_data.fork.parent_tgid, is_bash);
+            }
+            else if (ev->what == PROC_EVENT_EXEC)
+            {
+                size_t slot = pid_index_get(&tree->index, ev->event_data.exec.process_tgid);
+                Proc proc;
+                if (slot != (size_t)-1 && read_proc_info(ev->event_data.exec.process_tgid, &proc) == 0)
+                    tree->nodes[slot].is_bash = proc.is_bash;
+            }
+            else if (ev->what == PROC_EVENT_EXIT)
+            {
+                if (ev->event_data.exit.process_pid == ev->event_data.exit.process_tgid)
+                    live_tree_remove(tree, ev->event_data.exit.process_tgid);
+            }
         }
     }
-
-    free_proc_list(&parent_siblings);
 }
 
 /**
- * -kgc：向 process_id 的所有孙子进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程（即使 bash 进程是 process_id 的子进程），以免影响用户的正常操作。
- * 实现思路：
- * 1. 先用 collect_descendants(process_id, &descendants) 收集后代
- * 2. 识别直接子进程（ppid == process_id）
- * 3. 再筛选并终止这些子进程的直接子进程（即 grandchildren）
+ * 用途：从 stdin 读入数据，按行回答查询。返回 -1 表示 stdin 已关闭或收到 quit。
  */
-static void opt_kgc(pid_t process_id)
+static int daemon_read_queries(LiveTree *tree, char *line_buf, size_t line_cap, size_t *line_len)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
+    ssize_t n = read(STDIN_FILENO, line_buf + *line_len, line_cap - *line_len - 1);
+    if (n < 0)
+        return (errno == EINTR) ? 0 : -1;
+    if (n == 0)
+        return -1;
+    *line_len += (size_t)n;
+
+    size_t start = 0;
+    for (size_t i = 0; i < *line_len; i++)
     {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
+        if (line_buf[i] != '\n')
+            continue;
+
+        line_buf[i] = '\0';
+        char *line = line_buf + start;
+        start = i + 1;
+
+        if (strncmp(line, "quit", 4) == 0)
+            return -1;
+        daemon_answer(tree, line);
     }
+    fflush(stdout);
 
-    pid_t *child_pids = NULL;
-    size_t child_count = 0;
+    memmove(line_buf, line_buf + start, *line_len - start);
+    *line_len -= start;
+    if (*line_len == line_cap - 1) // 一行过长，丢弃
+        *line_len = 0;
+    return 0;
+}
 
-    for (size_t i = 0; i < descendants.count; i++)
-    {
-        if (descendants.proc_items[i].ppid == process_id)
+/**
+ * -daemon [poll_seconds]：常驻运行，在内存中增量维护整棵进程树，从 stdin 逐行读取查询
+ * （"root_process process_id [-cnt|-oct|-dnd]"），输出格式与命令行相同；stdin 关闭或输入 quit 时退出。
+ * 实现思路：
+ * 1. 先订阅 netlink 进程连接器，再建立一次完整快照，保证两者之间发生的事件不会丢失
+ * 2. 收到 fork/exec/exit 事件时只改动相关节点；查询只遍历被问到的子树，不做 I/O
+ * 3. 没有 CAP_NET_ADMIN（或内核不支持）时退回到每 poll_seconds 秒一次的快照 diff；
+ *    netlink 模式下事件丢失（ENOBUFS）或每 DAEMON_RESYNC_SECONDS 秒也做一次 diff 校正
+ */
+static void opt_daemon(double poll_seconds, int scan_threads)
+{
+    LiveTree tree;
+    memset(&tree, 0, sizeof(tree));
+
+    int sock = proc_connector_open();
+    if (sock < 0)
+        fprintf(stderr, "netlink proc connector unavailable (%s), polling /proc every %.2f s\n", strerror(errno), poll_seconds);
+
+    Snapshot snap;
+    if (snapshot_build(&snap, scan_threads) != 0)
+        die_perror("snapshot /proc");
+    live_tree_sync(&tree, &snap);
+    free_snapshot(&snap);
+
+    double resync_every = (sock >= 0) ? DAEMON_RESYNC_SECONDS : poll_seconds;
+    double next_resync = monotonic_seconds() + resync_every;
+
+    char line_buf[4096];
+    size_t line_len = 0;
+    int need_resync = 0;
+
+    while (1)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        fds[1].fd = sock;
+        fds[1].events = POLLIN;
+
+        double wait = next_resync - monotonic_seconds();
+        int timeout_ms = (wait > 0) ? (int)(wait * 1000) + 1 : 0;
+        int ready = poll(fds, (sock >= 0) ? 2 : 1, timeout_ms);
+        if (ready < 0 && errno != EINTR)
+            die_perror("poll");
+
+        /* 先应用事件，再回答查询，保证答案反映已收到的所有变化 */
+        if (ready > 0 && sock >= 0 && (fds[1].revents & POLLIN))
         {
-            if (append_pid(&child_pids, &child_count, descendants.proc_items[i].pid) != 0)
+            int rc = proc_connector_drain(sock, &tree);
+            if (rc != 0)
+                need_resync = 1;
+            if (rc < 0)
             {
-                free(child_pids);
-                free_proc_list(&descendants);
-                die_perror("realloc");
+                fprintf(stderr, "netlink proc connector failed, falling back to polling every %.2f s\n", poll_seconds);
+                close(sock);
+                sock = -1;
+                resync_every = poll_seconds;
             }
         }
-    }
 
-    for (size_t i = 0; i < descendants.count; i++)
-    {
-        Proc *proc = &descendants.proc_items[i];
-
-        if (!pid_in_list(proc->ppid, child_pids, child_count))
-            continue;
-
-        if (proc->is_bash)
+        if (need_resync || monotonic_seconds() >= next_resync)
         {
-            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)proc->pid);
-            continue;
+            if (snapshot_build(&snap, scan_threads) == 0)
+            {
+                live_tree_sync(&tree, &snap);
+                free_snapshot(&snap);
+            }
+            need_resync = 0;
+            next_resync = monotonic_seconds() + resync_every;
         }
 
-        if (kill(proc->pid, SIGKILL) != 0)
+        if (ready > 0 && (fds[0].revents & (POLLIN | POLLHUP)))
         {
-            if (errno == ESRCH)
-                continue;
-
-            fprintf(stderr, "Failed to kill grandchild %d: %s\n", (int)proc->pid, strerror(errno));
+            if (daemon_read_queries(&tree, line_buf, sizeof(line_buf), &line_len) != 0)
+                break;
         }
     }
 
-    free(child_pids);
-    free_proc_list(&descendants);
+    if (sock >= 0)
+        close(sock);
+    free_live_tree(&tree);
+}
+
+/* 用途：只读查询选项（不发信号、不改变任何进程）的处理函数。命令行和 -batch 共用这张表。 */
+typedef void (*QueryFn)(const Snapshot *snap, pid_t process_id);
+
+static const struct
+{
+    const char *name;
+    QueryFn fn;
+} QUERY_OPTIONS[] = {
+    {"-cnt", opt_cnt},
+    {"-oct", opt_oct},
+    {"-odt", opt_odt},
+    {"-ndt", opt_ndt},
+    {"-dnd", opt_dnd},
+    {"-mmd", opt_mmd},
+    {"-mpd", opt_mpd},
+};
+
+static QueryFn find_query_option(const char *opt)
+{
+    for (size_t i = 0; i < sizeof(QUERY_OPTIONS) / sizeof(QUERY_OPTIONS[0]); i++)
+    {
+        if (strcmp(QUERY_OPTIONS[i].name, opt) == 0)
+            return QUERY_OPTIONS[i].fn;
+    }
+    return NULL;
 }
 
 /**
- * -kcp：向 process_id 的所有子进程发送 SIGKILL 信号，要求它们终止。要求不杀死 bash 进程（即使 bash 进程是 process_id 的子进程），以免影响用户的正常操作。
+ * 用途：解析一个正的 pid（1 .. INT_MAX），成功返回 0。
+ */
+static int parse_pid(const char *text, pid_t *pid_out)
+{
+    char *end = NULL;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0 || value > INT_MAX)
+        return -1;
+
+    *pid_out = (pid_t)value;
+    return 0;
+}
+
+/**
+ * -batch [options]：只遍历一次 /proc，回答 stdin 中的全部查询。
+ * 每行一个查询 "root_process process_id"，对每个查询依次执行默认功能和 options 中的每个只读选项。
  * 实现思路：
- * 1. 先用 collect_descendants(process_id, &descendants) 收集后代
- * 2. 识别直接子进程（ppid == process_id）
- * 3. 对这些直接子进程发送 SIGKILL
+ * 1. 选项可以用逗号分隔或分成多个参数给出，开始前全部校验，只接受 QUERY_OPTIONS 中的只读选项
+ * 2. 所有查询共用调用方建立的同一个快照
+ * 3. 每个查询前输出 "# root_process process_id"，每个选项前输出 "# option"，之后的内容与命令行完全相同；
+ *    process_id 不属于该子树时只输出默认功能的结果
  */
-static void opt_kcp(pid_t process_id)
+static int opt_batch(const Snapshot *snap, char **options, size_t option_count)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
-    }
+    char line[256];
+    size_t line_no = 0;
+    int bad_lines = 0;
 
-    for (size_t i = 0; i < descendants.count; i++)
+    while (fgets(line, sizeof(line), stdin))
     {
-        Proc *proc = &descendants.proc_items[i];
+        line_no++;
 
-        if (proc->ppid != process_id)
-            continue;
+        char *saveptr = NULL;
+        char *root_text = strtok_r(line, " \t\r\n", &saveptr);
+        char *pid_text = strtok_r(NULL, " \t\r\n", &saveptr);
+        if (!root_text || root_text[0] == '#')
+            continue; // 空行和注释
 
-        if (proc->is_bash)
+        pid_t root_process = 0;
+        pid_t process_id = 0;
+        if (!pid_text || strtok_r(NULL, " \t\r\n", &saveptr) ||
+            parse_pid(root_text, &root_process) != 0 || parse_pid(pid_text, &process_id) != 0)
         {
-            fprintf(stderr, "Process %d is BASH and will not be terminated\n", (int)proc->pid);
+            fprintf(stderr, "Invalid query on line %zu, expected: root_process process_id\n", line_no);
+            bad_lines++;
             continue;
         }
 
-        if (kill(proc->pid, SIGKILL) != 0)
-        {
-            if (errno == ESRCH)
-                continue;
+        printf("# %d %d\n", (int)root_process, (int)process_id);
+        if (opt_default(snap, process_id, root_process) != 0)
+            continue;
 
-            fprintf(stderr, "Failed to kill child %d: %s\n", (int)proc->pid, strerror(errno));
+        for (size_t i = 0; i < option_count; i++)
+        {
+            printf("# %s\n", options[i]);
+            find_query_option(options[i])(snap, process_id);
         }
     }
 
-    free_proc_list(&descendants);
+    return bad_lines == 0 ? 0 : -1;
 }
 
 /**
- * -krp：向 root_process 发送 SIGKILL 信号，要求它终止。要求不杀死 bash 进程（即使 bash 进程是 root_process），以免影响用户的正常操作。
- * 实现思路：
- * 1. 如果 root_process 不存在或者不大于 1，就说明 root_process 没有父进程或者父进程是 init 进程了，这时不杀死 root_process
- * 2. 如果 root_process 是 bash 进程，就不杀死 root_process
- * 3. 否则，向 root_process 发送 SIGKILL 信号
+ * 用途：判断某个选项后面是否还带有自己的参数（如 -watch <interval>）。
  */
-static void opt_krp(pid_t root_process)
+static int option_takes_args(const char *opt)
 {
-    if (root_process <= 1)
-    {
-        fprintf(stderr, "Root process is not a user process and will not be terminated\n");
-        return;
-    }
-
-    if (is_bash_process(root_process))
-    {
-        fprintf(stderr, "Root process is BASH and will not be terminated\n");
-        return;
-    }
-
-    if (kill(root_process, SIGKILL) != 0)
-    {
-        if (errno == ESRCH)
-        {
-            fprintf(stderr, "Root process %d no longer exists\n", (int)root_process);
-            return;
-        }
+    return strcmp(opt, "-watch") == 0;
+}
 
-        fprintf(stderr, "Failed to kill root process %d: %s\n", (int)root_process, strerror(errno));
-        return;
-    }
+/**
+ * 用途：解析一个正的秒数（可以是小数，如 0.5），保存在 seconds_out 中。
+ */
+static int parse_seconds(const char *text, double *seconds_out)
+{
+    char *end = NULL;
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value > 0) || value > 86400)
+        return -1;
 
-    printf("SIGKILL was sent to process %d\n", (int)root_process);
+    *seconds_out = value;
+    return 0;
 }
 
 /**
- * -mmd：列出 process_id 的后代中占用内存最多的进程（VmRSS 最大）以及该 VmRSS 值。
- * 实现思路：
- * 1. 先用 collect_descendants(process_id, &descendants) 收集后代
- * 2. 遍历 descendants，找出最大 vmrss_bytes
- * 3. 再遍历一次，输出所有 vmrss_bytes 等于最大值的后代（处理并列）
- * 4. 输出最大 VmRSS（bytes）
+ * 用途：解析一个正整数个数，保存在 count_out 中。
  */
-static void opt_mmd(pid_t process_id)
+static int parse_count(const char *text, size_t *count_out)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
-    }
+    char *end = NULL;
+    long long value = strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0)
+        return -1;
 
-    if (descendants.count == 0)
-    {
-        free_proc_list(&descendants);
-        return;
-    }
+    *count_out = (size_t)value;
+    return 0;
+}
 
-    long long max_vmrss = -1;
-    for (size_t i = 0; i < descendants.count; i++)
+/**
+ * 用途：从 argv 中取出全局选项（目前只有 --threads N），并把它们从 argv 中删除，剩下的参数按原有规则解析。
+ * 返回 0 表示成功，-1 表示全局选项的值不合法。
+ */
+static int take_global_options(int *argc, char **argv, int *scan_threads)
+{
+    int out = 1;
+    for (int i = 1; i < *argc; i++)
     {
-        if (descendants.proc_items[i].vmrss_bytes > max_vmrss)
-            max_vmrss = descendants.proc_items[i].vmrss_bytes;
-    }
+        if (strcmp(argv[i], "--threads") == 0)
+        {
+            if (i + 1 >= *argc)
+                return -1;
 
-    if (max_vmrss < 0)
-    {
-        fprintf(stderr, "No VmRSS information available for descendants of %d\n", (int)process_id);
-        free_proc_list(&descendants);
-        return;
-    }
+            char *end = NULL;
+            long value = strtol(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end != '\0' || value < 0 || value > 1024)
+                return -1;
 
-    for (size_t i = 0; i < descendants.count; i++)
-    {
-        if (descendants.proc_items[i].vmrss_bytes == max_vmrss)
-        {
-            printf("%d is the descendant of %d consuming the most memory.\n",
-                   (int)descendants.proc_items[i].pid,
-                   (int)process_id);
+            if (value == 0)
+            {
+                long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                value = (cpus > 0) ? cpus : 1;
+            }
+            *scan_threads = (int)value;
+            i++;
+            continue;
         }
+
+        argv[out++] = argv[i];
     }
-    printf("VmRSS: %lld bytes\n", max_vmrss);
 
-    free_proc_list(&descendants);
+    *argc = out;
+    argv[out] = NULL;
+    return 0;
 }
 
-/**
- * -mpd：列出 process_id 的后代中累计 CPU 时间最多的进程（utime+stime 最大），并输出该累计时钟 tick 值。
- * 实现思路：
- * 1. 先用 collect_descendants(process_id, &descendants) 收集后代
- * 2. 对每个后代计算 cpu_ticks = utime_ticks + stime_ticks，找出最大值
- * 3. 再遍历一次，输出所有 cpu_ticks 等于最大值的后代（处理并列）
- * 4. 输出最大累计 CPU 时间（clock ticks）
- */
-static void opt_mpd(pid_t process_id)
+#ifndef A2_NO_MAIN
+int main(int argc, char **argv)
 {
-    ProcList descendants = {0};
-    if (collect_descendants(process_id, &descendants) != 0)
-    {
-        fprintf(stderr, "Cannot collect descendants of process %d\n", (int)process_id);
-        return;
-    }
+    Snapshot snap;
+    int scan_threads = 1;
 
-    if (descendants.count == 0)
+    if (take_global_options(&argc, argv, &scan_threads) != 0)
     {
-        free_proc_list(&descendants);
-        return;
+        fprintf(stderr, "Invalid --threads value, must be an integer in [0, 1024].\n");
+        usage(argv[0]);
+        return EXIT_FAILURE;
     }
 
-    unsigned long long max_cpu_ticks = 0;
-    int found = 0;
-    for (size_t i = 0; i < descendants.count; i++)
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "-daemon") == 0)
     {
-        unsigned long long cpu_ticks =
-            (unsigned long long)descendants.proc_items[i].utime_ticks +
-            (unsigned long long)descendants.proc_items[i].stime_ticks;
-        if (!found || cpu_ticks > max_cpu_ticks)
+        double poll_seconds = DAEMON_DEFAULT_POLL_SECONDS;
+        if (argc == 3 && parse_seconds(argv[2], &poll_seconds) != 0)
         {
-            max_cpu_ticks = cpu_ticks;
-            found = 1;
+            usage(argv[0]);
+            return EXIT_FAILURE;
         }
+        opt_daemon(poll_seconds, scan_threads);
+        return 0;
     }
 
-    for (size_t i = 0; i < descendants.count; i++)
+    if (argc >= 2 && strcmp(argv[1], "-batch") == 0)
     {
-        unsigned long long cpu_ticks =
-            (unsigned long long)descendants.proc_items[i].utime_ticks +
-            (unsigned long long)descendants.proc_items[i].stime_ticks;
-        if (cpu_ticks == max_cpu_ticks)
+        /* 选项可以写成 "-cnt,-oct" 或 "-cnt -oct"，就地按逗号切分 */
+        size_t option_cap = 1;
+        for (int i = 2; i < argc; i++)
         {
-            printf("%d is the descendant of %d that has used the most CPU time.\n",
-                   (int)descendants.proc_items[i].pid,
-                   (int)process_id);
+            for (const char *c = argv[i]; *c; c++)
+                option_cap += (*c == ',');
+            option_cap++;
         }
-    }
-    printf("Total CPU time: %llu clock ticks\n", max_cpu_ticks);
 
-    free_proc_list(&descendants);
-}
+        char **options = malloc(option_cap * sizeof(*options));
+        size_t option_count = 0;
+        if (!options)
+            die_perror("malloc");
 
-int main(int argc, char **argv)
-{
+        for (int i = 2; i < argc; i++)
+        {
+            char *saveptr = NULL;
+            for (char *tok = strtok_r(argv[i], ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr))
+            {
+                if (!find_query_option(tok))
+                {
+                    fprintf(stderr, "Option %s is not a read-only query and cannot be used with -batch\n", tok);
+                    free(options);
+                    return EXIT_FAILURE;
+                }
+                options[option_count++] = tok;
+            }
+        }
 
-    if (argc == 2 && strcmp(argv[1], "-bcp") == 0)
-    {
-        opt_bcp();
-        return 0;
+        if (snapshot_build(&snap, scan_threads) != 0)
+            die_perror("snapshot /proc");
+        int rc = opt_batch(&snap, options, option_count);
+        free_snapshot(&snap);
+        free(options);
+        return rc == 0 ? 0 : EXIT_FAILURE;
     }
-    if (argc == 2 && strcmp(argv[1], "-bop") == 0)
+
+    if (argc == 2 && (strcmp(argv[1], "-bcp") == 0 || strcmp(argv[1], "-bop") == 0))
     {
-        opt_bop();
+        if (snapshot_build(&snap, scan_threads) != 0)
+            die_perror("snapshot /proc");
+
+        if (strcmp(argv[1], "-bcp") == 0)
+            opt_bcp(&snap);
+        else
+            opt_bop(&snap);
+
+        free_snapshot(&snap);
         return 0;
     }
 
-    if (argc < 3 || argc > 4)
+    if (argc < 3 || (argc > 4 && !option_takes_args(argv[3])))
     {
         usage(argv[0]);
         return EXIT_FAILURE;
@@ -1386,63 +3381,77 @@ int main(int argc, char **argv)
     pid_t root_process = (pid_t)argv1;
     pid_t process_id = (pid_t)argv2;
 
+    // one /proc pass serves the membership check and the selected option
+    if (snapshot_build(&snap, scan_threads) != 0)
+        die_perror("snapshot /proc");
+
     // no option, do default process
+    if (opt_default(&snap, process_id, root_process) != 0)
+    {
+        free_snapshot(&snap);
+        return EXIT_FAILURE;
+    }
     if (argc == 3)
     {
-        if (opt_default(process_id, root_process) != 0)
-            return EXIT_FAILURE;
+        free_snapshot(&snap);
         return 0;
     }
-    if (opt_default(process_id, root_process) != 0)
-        return EXIT_FAILURE;
 
-    char *opt = (argc == 4) ? argv[3] : NULL;
+    char *opt = (argc >= 4) ? argv[3] : NULL;
     if (!opt)
     {
+        free_snapshot(&snap);
         usage(argv[0]);
         return EXIT_FAILURE;
     }
 
-    if (strcmp(opt, "-cnt") == 0)
-        opt_cnt(process_id);
-    else if (strcmp(opt, "-oct") == 0)
-        opt_oct(process_id);
+    int rc = 0;
+    QueryFn query = find_query_option(opt);
+    if (query)
+        query(&snap, process_id);
     else if (strcmp(opt, "-dtm") == 0)
-        opt_dtm(process_id);
-    else if (strcmp(opt, "-odt") == 0)
-        opt_odt(process_id);
-    else if (strcmp(opt, "-ndt") == 0)
-        opt_ndt(process_id);
-    else if (strcmp(opt, "-dnd") == 0)
-        opt_dnd(process_id);
+        opt_dtm(&snap, process_id, scan_threads);
     else if (strcmp(opt, "-sst") == 0)
-        opt_sst(process_id);
+        opt_sst(&snap, process_id);
     else if (strcmp(opt, "-sco") == 0)
-        opt_sco(process_id);
+        opt_sco(&snap, process_id);
     else if (strcmp(opt, "-kgp") == 0)
-        opt_kgp(process_id);
+        opt_kgp(&snap, process_id);
     else if (strcmp(opt, "-kpp") == 0)
-        opt_kpp(process_id);
+        opt_kpp(&snap, process_id);
     else if (strcmp(opt, "-ksp") == 0)
-        opt_ksp(process_id);
+        opt_ksp(&snap, process_id);
     else if (strcmp(opt, "-kps") == 0)
-        opt_kps(process_id);
+        opt_kps(&snap, process_id);
     else if (strcmp(opt, "-kgc") == 0)
-        opt_kgc(process_id);
+        opt_kgc(&snap, process_id, scan_threads);
     else if (strcmp(opt, "-kcp") == 0)
-        opt_kcp(process_id);
+        opt_kcp(&snap, process_id, scan_threads);
     else if (strcmp(opt, "-krp") == 0)
-        opt_krp(root_process);
-    else if (strcmp(opt, "-mmd") == 0)
-        opt_mmd(process_id);
-    else if (strcmp(opt, "-mpd") == 0)
-        opt_mpd(process_id);
+        opt_krp(&snap, root_process);
+    else if (strcmp(opt, "-watch") == 0)
+    {
+        double interval = 0;
+        size_t max_lines = 20;
+        if (argc < 5 || argc > 6 || parse_seconds(argv[4], &interval) != 0 ||
+            (argc == 6 && parse_count(argv[5], &max_lines) != 0))
+        {
+            fprintf(stderr, "Usage: %s root_process process_id -watch <interval_seconds> [lines]\n", argv[0]);
+            rc = EXIT_FAILURE;
+        }
+        else
+        {
+            opt_watch(&snap, process_id, interval, max_lines, scan_threads);
+        }
+    }
     else
     {
         printf("Unknown option: %s\n", opt);
         usage(argv[0]);
-        return EXIT_FAILURE;
+        rc = EXIT_FAILURE;
     }
 
-    return 0;
-}
\ No newline at end of file
+    free_snapshot(&snap);
+    return rc;
+}
+#endif /* A2_NO_MAIN */
@@ -0,0 +1,652 @@
+/*
+ * a2bench.c
+ * 合成进程树生成器 + A2 各选项的基准测试。
+ *
+ * 编译：gcc -O2 a2bench.c -o a2bench
+ * 运行：
+ *   ./a2bench spawn [tree options]            只生成进程树，打印根 pid，回车或 Ctrl-C 后销毁
+ *   ./a2bench run [tree options] [run options] 对每种规模生成进程树，依次计时 A2 的各个选项
+ *
+ * tree options：
+ *   --size N        树中进程个数（默认 1000）；与 --sizes 一起使用时被覆盖
+ *   --fanout F      每个进程的子进程个数（默认 4；1 表示一条链）
+ *   --depth D       最大深度，超过的节点不再生成（默认不限）
+ *   --stopped P     处于停止状态（SIGSTOP）的进程所占百分比（默认 0）
+ *   --zombie P      僵尸进程所占百分比，只对叶子节点生效（默认 0）
+ *   --orphan P      中间父进程已退出、被根进程（subreaper）收养的进程所占百分比（默认 0）
+ *   --bash P        comm 被改成 "bash" 的诱饵进程所占百分比（默认 0）
+ *   --seed S        角色分配的随机种子（默认 1）
+ *
+ * run options：
+ *   --sizes a,b,c   依次测试的规模（默认 100,1000,10000,50000）
+ *   --a2 PATH       A2 可执行文件（默认 ./A2）
+ *   --options LIST  要测试的选项，逗号分隔；"default" 表示不带选项（默认：除 kill 类以外的全部选项；
+ *                   -sst/-sco 以节点 1 为 process_id，只会停止/继续生成的树中的兄弟节点）
+ *   --repeat R      每个选项运行的次数，取中位数（默认 5）
+ *   --threads N     原样传给 A2 的 --threads
+ *
+ * 每个选项报告墙钟时间（中位数与最小值）、用户态/内核态 CPU 时间、
+ * 读/写类系统调用次数（/proc/<pid>/io 中的 syscr/syscw）和峰值 RSS（wait4 返回的 ru_maxrss）。
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_OPTIONS 32
+#define BENCH_MAX_REPEAT 101
+#define BENCH_READY_TIMEOUT_SECONDS 300.0
+
+/* 用途：进程树的形状和各种角色的比例。 */
+typedef struct TreeSpec
+{
+    long size;
+    long fanout;
+    long depth; /* -1 表示不限 */
+    int stopped_pct;
+    int zombie_pct;
+    int orphan_pct;
+    int bash_pct;
+    unsigned seed;
+} TreeSpec;
+
+/* 用途：节点在树中的角色。 */
+typedef enum NodeRole
+{
+    ROLE_LIVE,
+    ROLE_STOPPED,
+    ROLE_ZOMBIE,
+    ROLE_BASH
+} NodeRole;
+
+/* 用途：生成器各进程之间共享的状态（MAP_SHARED 匿名映射）。pids[id] 是节点 id 的 pid。 */
+typedef struct SharedTree
+{
+    volatile long ready; /* 已就位的节点个数 */
+    volatile long failed;
+    pid_t pids[];
+} SharedTree;
+
+/* 用途：一次 A2 运行的测量结果。 */
+typedef struct RunSample
+{
+    double wall_ms;
+    double user_ms;
+    double sys_ms;
+    long long syscr;
+    long long syscw;
+    long maxrss_kb;
+    int exit_ok;
+} RunSample;
+
+static void die_perror(const char *msg)
+{
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+static double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * 用途：节点 id 的深度（根为 0）。节点按完全 F 叉树的层序编号：id 的父节点是 (id - 1) / F。
+ */
+static long node_depth(long id, long fanout)
+{
+    long depth = 0;
+    while (id > 0)
+    {
+        id = (id - 1) / fanout;
+        depth++;
+    }
+    return depth;
+}
+
+static int node_exists(const TreeSpec *spec, long id)
+{
+    return id < spec->size && (spec->depth < 0 || node_depth(id, spec->fanout) <= spec->depth);
+}
+
+static int node_is_leaf(const TreeSpec *spec, long id)
+{
+    return !node_exists(spec, id * spec->fanout + 1);
+}
+
+/**
+ * 用途：由种子和 id 得到一个 [0, 100) 的伪随机数，salt 区分不同用途，保证同样的参数得到同样的树。
+ */
+static int node_roll(const TreeSpec *spec, long id, unsigned salt)
+{
+    unsigned long long x = ((unsigned long long)spec->seed << 32) ^ (unsigned long long)id ^ ((unsigned long long)salt << 56);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb3f99ea1c7ecULL;
+    x ^= x >> 33;
+    return (int)(x % 100);
+}
+
+static NodeRole node_role(const TreeSpec *spec, long id)
+{
+    if (id == 0)
+        return ROLE_LIVE;
+
+    int roll = node_roll(spec, id, 1);
+    if (roll < spec->zombie_pct)
+        return node_is_leaf(spec, id) ? ROLE_ZOMBIE : ROLE_LIVE;
+    roll -= spec->zombie_pct;
+    if (roll < spec->stopped_pct)
+        return ROLE_STOPPED;
+    roll -= spec->stopped_pct;
+    if (roll < spec->bash_pct)
+        return ROLE_BASH;
+    return ROLE_LIVE;
+}
+
+static int node_is_orphan(const TreeSpec *spec, long id)
+{
+    return id > 0 && node_roll(spec, id, 2) < spec->orphan_pct;
+}
+
+/**
+ * 用途：树中实际存在的节点个数（--depth 可能截掉一部分）。
+ */
+static long tree_node_count(const TreeSpec *spec)
+{
+    long count = 0;
+    for (long id = 0; id < spec->size; id++)
+        count += node_exists(spec, id);
+    return count;
+}
+
+static void run_node(const TreeSpec *spec, SharedTree *shared, long id);
+
+/**
+ * 用途：为节点 id 创建进程。orphan 节点先经过一个中间进程：中间进程 fork 出真正的节点后立即退出，
+ * 节点因此被根进程（subreaper）收养。返回需要父进程回收的 pid（中间进程），没有则返回 0。
+ */
+static pid_t spawn_node(const TreeSpec *spec, SharedTree *shared, long id)
+{
+    int orphan = node_is_orphan(spec, id);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        __sync_fetch_and_add(&shared->failed, 1);
+        return 0;
+    }
+    if (pid > 0)
+        return orphan ? pid : 0;
+
+    if (orphan)
+    {
+        pid_t inner = fork();
+        if (inner < 0)
+            __sync_fetch_and_add(&shared->failed, 1);
+        if (inner != 0)
+            _exit(0);
+    }
+    run_node(spec, shared, id);
+    _exit(0);
+}
+
+/**
+ * 用途：一个节点进程的全部工作：生成自己的子节点，然后按角色停在相应状态，直到整棵树被销毁。
+ */
+static void run_node(const TreeSpec *spec, SharedTree *shared, long id)
+{
+    shared->pids[id] = getpid();
+
+    NodeRole role = node_role(spec, id);
+    prctl(PR_SET_NAME, role == ROLE_BASH ? "bash" : "a2node");
+
+    if (role == ROLE_ZOMBIE)
+    {
+        __sync_fetch_and_add(&shared->ready, 1);
+        _exit(0); // 父进程从不 wait 它，于是留下僵尸
+    }
+
+    pid_t reap[64];
+    size_t reap_count = 0;
+    for (long c = 1; c <= spec->fanout; c++)
+    {
+        long child = id * spec->fanout + c;
+        if (!node_exists(spec, child))
+            break;
+
+        pid_t middle = spawn_node(spec, shared, child);
+        if (middle > 0)
+            reap[reap_count++] = middle; // fanout 不超过 64
+    }
+    for (size_t i = 0; i < reap_count; i++)
+        waitpid(reap[i], NULL, 0);
+
+    __sync_fetch_and_add(&shared->ready, 1);
+    if (role == ROLE_STOPPED)
+        raise(SIGSTOP);
+    while (1)
+        pause();
+}
+
+/**
+ * 用途：在一个新的进程组中生成整棵树，等待所有节点就位。返回根 pid，失败返回 -1。
+ * 根进程设置为 child subreaper，使 orphan 节点和它们的子树仍留在这棵树里。
+ */
+static pid_t tree_spawn(const TreeSpec *spec, SharedTree **shared_out, size_t *shared_size_out)
+{
+    size_t shared_size = sizeof(SharedTree) + (size_t)spec->size * sizeof(pid_t);
+    SharedTree *shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+        die_perror("mmap");
+
+    long expected = tree_node_count(spec);
+
+    pid_t root = fork();
+    if (root < 0)
+        die_perror("fork");
+    if (root == 0)
+    {
+        setpgid(0, 0);
+        prctl(PR_SET_CHILD_SUBREAPER, 1);
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        run_node(spec, shared, 0);
+        _exit(0);
+    }
+    setpgid(root, root);
+
+    double deadline = monotonic_seconds() + BENCH_READY_TIMEOUT_SECONDS;
+    while (shared->ready + shared->failed < expected)
+    {
+        if (monotonic_seconds() > deadline)
+            break;
+        usleep(2000);
+    }
+
+    if (shared->ready < expected)
+    {
+        fprintf(stderr, "tree not ready: %ld of %ld processes (%ld forks failed)\n", shared->ready, expected, shared->failed);
+        kill(-root, SIGKILL);
+        waitpid(root, NULL, 0);
+        munmap(shared, shared_size);
+        return -1;
+    }
+
+    *shared_out = shared;
+    *shared_size_out = shared_size;
+    return root;
+}
+
+/**
+ * 用途：销毁整棵树：向进程组发 SIGKILL（停止状态的进程也会被杀死），再回收根进程。
+ */
+static void tree_destroy(pid_t root, SharedTree *shared, size_t shared_size)
+{
+    kill(-root, SIGKILL);
+    waitpid(root, NULL, 0);
+    munmap(shared, shared_size);
+}
+
+/**
+ * 用途：读取已退出（尚未回收）的子进程的 /proc/<pid>/io 中的 syscr 和 syscw。
+ */
+static void read_syscall_counts(pid_t pid, long long *syscr_out, long long *syscw_out)
+{
+    *syscr_out = -1;
+    *syscw_out = -1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return;
+
+    char line[128];
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, "syscr:", 6) == 0)
+            *syscr_out = strtoll(line + 6, NULL, 10);
+        else if (strncmp(line, "syscw:", 6) == 0)
+            *syscw_out = strtoll(line + 6, NULL, 10);
+    }
+    fclose(fp);
+}
+
+/**
+ * 用途：运行一次 A2（stdout/stderr 丢弃），测量墙钟时间、CPU 时间、系统调用次数和峰值 RSS。
+ * 实现思路：
+ * 1. waitid(WNOWAIT) 等待子进程退出但不回收，此时还能读取它的 /proc/<pid>/io
+ * 2. 再用 wait4 回收，得到 rusage
+ */
+static int run_a2_once(char *const argv[], RunSample *sample)
+{
+    memset(sample, 0, sizeof(*sample));
+
+    double start = monotonic_seconds();
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+    if (pid == 0)
+    {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0)
+        {
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    while (waitid(P_PID, (id_t)pid, &info, WEXITED | WNOWAIT) != 0)
+    {
+        if (errno != EINTR)
+            return -1;
+    }
+    sample->wall_ms = (monotonic_seconds() - start) * 1e3;
+    read_syscall_counts(pid, &sample->syscr, &sample->syscw);
+
+    int status = 0;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) != pid)
+        return -1;
+
+    sample->user_ms = (double)ru.ru_utime.tv_sec * 1e3 + (double)ru.ru_utime.tv_usec / 1e3;
+    sample->sys_ms = (double)ru.ru_stime.tv_sec * 1e3 + (double)ru.ru_stime.tv_usec / 1e3;
+    sample->maxrss_kb = ru.ru_maxrss;
+    sample->exit_ok = WIFEXITED(status) && WEXITSTATUS(status) != 127;
+    return 0;
+}
+
+static int cmp_sample_wall(const void *a, const void *b)
+{
+    const RunSample *ea = (const RunSample *)a;
+    const RunSample *eb = (const RunSample *)b;
+    return (ea->wall_ms > eb->wall_ms) - (ea->wall_ms < eb->wall_ms);
+}
+
+/**
+ * 用途：为一个选项拼出 A2 的命令行。需要兄弟进程的选项（-sst、-sco 等）以节点 1 为 process_id，
+ * 其它选项以根为 process_id；-bcp、-bop 不带 pid。
+ */
+static void build_a2_argv(char **argv, char pid_buf[2][16], const char *a2_path, const char *threads,
+                          const char *option, pid_t root, pid_t first_child)
+{
+    int n = 0;
+    argv[n++] = (char *)a2_path;
+    if (threads)
+    {
+        argv[n++] = "--threads";
+        argv[n++] = (char *)threads;
+    }
+
+    if (strcmp(option, "-bcp") == 0 || strcmp(option, "-bop") == 0)
+    {
+        argv[n++] = (char *)option;
+        argv[n] = NULL;
+        return;
+    }
+
+    int use_child = (strcmp(option, "-sst") == 0 || strcmp(option, "-sco") == 0) && first_child > 0;
+    snprintf(pid_buf[0], 16, "%d", (int)root);
+    snprintf(pid_buf[1], 16, "%d", (int)(use_child ? first_child : root));
+    argv[n++] = pid_buf[0];
+    argv[n++] = pid_buf[1];
+    if (strcmp(option, "default") != 0)
+        argv[n++] = (char *)option;
+    argv[n] = NULL;
+}
+
+/**
+ * 用途：对一棵已生成的树，依次运行每个选项 repeat 次并打印一行结果。
+ */
+static void bench_options(const char *a2_path, const char *threads, char **options, int option_count, int repeat,
+                          pid_t root, pid_t first_child, long tree_size)
+{
+    printf("%-9s %8s %10s %10s %9s %9s %10s %8s %10s\n",
+           "option", "procs", "median_ms", "min_ms", "user_ms", "sys_ms", "syscr", "syscw", "maxrss_kb");
+
+    for (int o = 0; o < option_count; o++)
+    {
+        char *argv[8];
+        char pid_buf[2][16];
+        build_a2_argv(argv, pid_buf, a2_path, threads, options[o], root, first_child);
+
+        RunSample samples[BENCH_MAX_REPEAT];
+        int ok = 1;
+        for (int r = 0; r < repeat; r++)
+        {
+            if (run_a2_once(argv, &samples[r]) != 0 || !samples[r].exit_ok)
+            {
+                ok = 0;
+                break;
+            }
+        }
+        if (!ok)
+        {
+            printf("%-9s %8ld  failed to run %s\n", options[o], tree_size, a2_path);
+            continue;
+        }
+
+        qsort(samples, (size_t)repeat, sizeof(samples[0]), cmp_sample_wall);
+        const RunSample *median = &samples[repeat / 2];
+        printf("%-9s %8ld %10.2f %10.2f %9.2f %9.2f %10lld %8lld %10ld\n",
+               options[o], tree_size, median->wall_ms, samples[0].wall_ms, median->user_ms, median->sys_ms,
+               median->syscr, median->syscw, median->maxrss_kb);
+        fflush(stdout);
+    }
+}
+
+/**
+ * 用途：解析 "a,b,c" 形式的列表，就地切分，返回元素个数。
+ */
+static int split_list(char *text, char **items, int max_items)
+{
+    int count = 0;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(text, ",", &saveptr); tok && count < max_items; tok = strtok_r(NULL, ",", &saveptr))
+        items[count++] = tok;
+    return count;
+}
+
+static long pid_max_value(void)
+{
+    FILE *fp = fopen("/proc/sys/kernel/pid_max", "r");
+    long value = 32768;
+    if (fp)
+    {
+        if (fscanf(fp, "%ld", &value) != 1)
+            value = 32768;
+        fclose(fp);
+    }
+    return value;
+}
+
+static void on_interrupt(int sig)
+{
+    (void)sig;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s spawn [--size N] [--fanout F] [--depth D] [--stopped P] [--zombie P] [--orphan P] [--bash P] [--seed S]\n"
+            "  %s run   [tree options] [--sizes a,b,c] [--a2 PATH] [--options -cnt,-oct,...] [--repeat R] [--threads N]\n",
+            prog, prog);
+}
+
+static int parse_long_arg(const char *text, long min, long max, long *value_out)
+{
+    char *end = NULL;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < min || value > max)
+        return -1;
+    *value_out = value;
+    return 0;
+}
+
+static int parse_percent(const char *text, int *pct_out)
+{
+    long value = 0;
+    if (parse_long_arg(text, 0, 100, &value) != 0)
+        return -1;
+    *pct_out = (int)value;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || (strcmp(argv[1], "spawn") != 0 && strcmp(argv[1], "run") != 0))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    int run_mode = (strcmp(argv[1], "run") == 0);
+
+    TreeSpec spec = {1000, 4, -1, 0, 0, 0, 0, 1};
+    char default_sizes[] = "100,1000,10000,50000";
+    char default_options[] = "default,-cnt,-oct,-odt,-ndt,-dnd,-sst,-sco,-mmd,-mpd,-bop,-bcp";
+    char *sizes_text = NULL;
+    char *options_text = default_options;
+    const char *a2_path = "./A2";
+    const char *threads = NULL;
+    long repeat = 5;
+
+    for (int i = 2; i < argc; i++)
+    {
+        long value = 0;
+        const char *name = argv[i];
+        const char *arg = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!arg)
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        i++;
+
+        int bad = 0;
+        if (strcmp(name, "--size") == 0)
+            bad = parse_long_arg(arg, 1, 10000000, &spec.size);
+        else if (strcmp(name, "--fanout") == 0)
+            bad = parse_long_arg(arg, 1, 64, &spec.fanout);
+        else if (strcmp(name, "--depth") == 0)
+            bad = parse_long_arg(arg, 0, 10000000, &spec.depth);
+        else if (strcmp(name, "--stopped") == 0)
+            bad = parse_percent(arg, &spec.stopped_pct);
+        else if (strcmp(name, "--zombie") == 0)
+            bad = parse_percent(arg, &spec.zombie_pct);
+        else if (strcmp(name, "--orphan") == 0)
+            bad = parse_percent(arg, &spec.orphan_pct);
+        else if (strcmp(name, "--bash") == 0)
+            bad = parse_percent(arg, &spec.bash_pct);
+        else if (strcmp(name, "--seed") == 0)
+        {
+            bad = parse_long_arg(arg, 0, 0x7fffffffL, &value);
+            spec.seed = (unsigned)value;
+        }
+        else if (run_mode && strcmp(name, "--sizes") == 0)
+            sizes_text = (char *)arg;
+        else if (run_mode && strcmp(name, "--a2") == 0)
+            a2_path = arg;
+        else if (run_mode && strcmp(name, "--options") == 0)
+            options_text = (char *)arg;
+        else if (run_mode && strcmp(name, "--repeat") == 0)
+            bad = parse_long_arg(arg, 1, BENCH_MAX_REPEAT, &repeat);
+        else if (run_mode && strcmp(name, "--threads") == 0)
+            threads = arg;
+        else
+            bad = -1;
+
+        if (bad != 0 || spec.zombie_pct + spec.stopped_pct + spec.bash_pct > 100)
+        {
+            fprintf(stderr, "Invalid value for %s: %s\n", name, arg);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!run_mode)
+    {
+        SharedTree *shared = NULL;
+        size_t shared_size = 0;
+        pid_t root = tree_spawn(&spec, &shared, &shared_size);
+        if (root < 0)
+            return EXIT_FAILURE;
+
+        /* Ctrl-C 只打断 getchar()，树仍由这里统一销毁，不会留下被 init 收养的节点 */
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_interrupt;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+
+        printf("root %d, %ld processes ready; press Enter to destroy the tree\n", (int)root, shared->ready);
+        fflush(stdout);
+        getchar();
+        tree_destroy(root, shared, shared_size);
+        return 0;
+    }
+
+    if (access(a2_path, X_OK) != 0)
+    {
+        fprintf(stderr, "A2 binary not found or not executable: %s (use --a2 PATH)\n", a2_path);
+        return EXIT_FAILURE;
+    }
+
+    char *size_items[BENCH_MAX_SIZES];
+    int size_count = split_list(sizes_text ? sizes_text : default_sizes, size_items, BENCH_MAX_SIZES);
+    char *options[BENCH_MAX_OPTIONS];
+    int option_count = split_list(options_text, options, BENCH_MAX_OPTIONS);
+
+    long pid_max = pid_max_value();
+    for (int s = 0; s < size_count; s++)
+    {
+        if (parse_long_arg(size_items[s], 1, 10000000, &spec.size) != 0)
+        {
+            fprintf(stderr, "Invalid size: %s\n", size_items[s]);
+            continue;
+        }
+
+        long nodes = tree_node_count(&spec);
+        if (nodes + 1024 > pid_max)
+        {
+            fprintf(stderr, "skipping size %ld: needs more pids than kernel.pid_max (%ld) allows; raise /proc/sys/kernel/pid_max\n",
+                    spec.size, pid_max);
+            continue;
+        }
+
+        double spawn_start = monotonic_seconds();
+        SharedTree *shared = NULL;
+        size_t shared_size = 0;
+        pid_t root = tree_spawn(&spec, &shared, &shared_size);
+        if (root < 0)
+            continue;
+
+        printf("\n# tree: %ld processes, fanout %ld, depth %s%ld, stopped %d%%, zombie %d%%, orphan %d%%, bash %d%% (spawned in %.2f s)\n",
+               nodes, spec.fanout, spec.depth < 0 ? "<=" : "", spec.depth < 0 ? node_depth(spec.size - 1, spec.fanout) : spec.depth,
+               spec.stopped_pct, spec.zombie_pct, spec.orphan_pct, spec.bash_pct, monotonic_seconds() - spawn_start);
+        bench_options(a2_path, threads, options, option_count, (int)repeat, root, (spec.size > 1) ? shared->pids[1] : 0, nodes);
+
+        tree_destroy(root, shared, shared_size);
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * a2parsebench.c
+ * 微基准：比较旧的 stdio 解析器（fopen/fgets/strtok_r + 读取整个 status）
+ * 与 A2.c 中基于 open/pread 的 read_proc_info()（stat + statm）。
+ *
+ * 编译：gcc -O2 -pthread a2parsebench.c -o a2parsebench
+ * 运行：./a2parsebench [rounds]
+ */
+
+#define A2_NO_MAIN
+#pragma GCC diagnostic ignored "-Wunused-function"
+#include "A2.c"
+
+/**
+ * 用途：旧版解析器（与修改前的 read_proc_info 相同），作为对照组。
+ */
+static int read_proc_info_stdio(pid_t pid, Proc *proc_out)
+{
+    memset(proc_out, 0, sizeof(*proc_out));
+    proc_out->pid = pid;
+    proc_out->ppid = -1;
+    proc_out->start_ticks = -1;
+    proc_out->vmrss_bytes = -1;
+
+    char stat_path[64];
+    snprintf(stat_path, sizeof(stat_path), "/proc/%d/stat", (int)pid);
+
+    FILE *fp = fopen(stat_path, "r");
+    if (!fp)
+        return -1;
+
+    char line[4096];
+    if (!fgets(line, sizeof(line), fp))
+    {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    char *right_paren = strrchr(line, ')');
+    if (!right_paren || *(right_paren + 1) != ' ')
+        return -1;
+
+    char *cursor = right_paren + 2;
+    int field_no = 3;
+    char *saveptr = NULL;
+    char *token = strtok_r(cursor, " ", &saveptr);
+
+    while (token)
+    {
+        if (field_no == 3)
+            proc_out->state = token[0];
+        else if (field_no == 4)
+            proc_out->ppid = (pid_t)strtol(token, NULL, 10);
+        else if (field_no == 14)
+            proc_out->utime_ticks = strtol(token, NULL, 10);
+        else if (field_no == 15)
+            proc_out->stime_ticks = strtol(token, NULL, 10);
+        else if (field_no == 22)
+            proc_out->start_ticks = strtoll(token, NULL, 10);
+
+        field_no++;
+        token = strtok_r(NULL, " ", &saveptr);
+    }
+
+    char status_path[64];
+    snprintf(status_path, sizeof(status_path), "/proc/%d/status", (int)pid);
+    fp = fopen(status_path, "r");
+    if (!fp)
+        return 0;
+
+    char status_line[256];
+    while (fgets(status_line, sizeof(status_line), fp))
+    {
+        if (strncmp(status_line, "Name:", 5) == 0)
+        {
+            char *p = status_line + 5;
+            while (*p && isspace((unsigned char)*p))
+                p++;
+            strncpy(proc_out->name, p, sizeof(proc_out->name) - 1);
+            proc_out->name[sizeof(proc_out->name) - 1] = '\0';
+            proc_out->name[strcspn(proc_out->name, "\n")] = '\0';
+        }
+        else if (strncmp(status_line, "VmRSS:", 6) == 0)
+        {
+            char *p = status_line + 6;
+            while (*p && isspace((unsigned char)*p))
+                p++;
+            long long vmrss_kb = strtoll(p, NULL, 10);
+            if (vmrss_kb >= 0)
+                proc_out->vmrss_bytes = vmrss_kb * 1024;
+        }
+    }
+    fclose(fp);
+
+    proc_out->is_bash = (strcmp(proc_out->name, "bash") == 0);
+    return 0;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * 用途：用 parser 把 pids 全部解析 rounds 遍，返回总耗时（秒），成功解析的次数保存在 parsed_out 中。
+ */
+static double time_parser(int (*parser)(pid_t, Proc *), const pid_t *pids, size_t count, int rounds, size_t *parsed_out)
+{
+    Proc proc;
+    size_t parsed = 0;
+
+    double start = now_seconds();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (parser(pids[i], &proc) == 0)
+                parsed++;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    *parsed_out = parsed;
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 20;
+    if (rounds <= 0)
+        rounds = 20;
+
+    pid_t *pids = NULL;
+    size_t count = 0;
+    if (list_proc_pids(&pids, &count) != 0 || count == 0)
+        die_perror("list /proc");
+
+    /* 先检查两种解析器在稳定字段上的结果一致（RSS 会随时间变化，不参与比较） */
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Proc a, b;
+        if (read_proc_info_stdio(pids[i], &a) != 0 || read_proc_info(pids[i], &b) != 0)
+            continue;
+        if (a.ppid != b.ppid || a.start_ticks != b.start_ticks || strcmp(a.name, b.name) != 0)
+        {
+            fprintf(stderr, "mismatch for pid %d: stdio=(%d,%lld,%s) pread=(%d,%lld,%s)\n",
+                    (int)pids[i], (int)a.ppid, a.start_ticks, a.name, (int)b.ppid, b.start_ticks, b.name);
+            mismatches++;
+        }
+    }
+
+    size_t parsed_stdio = 0;
+    size_t parsed_pread = 0;
+    double t_stdio = time_parser(read_proc_info_stdio, pids, count, rounds, &parsed_stdio);
+    double t_pread = time_parser(read_proc_info, pids, count, rounds, &parsed_pread);
+
+    printf("pids: %zu, rounds: %d, mismatches: %zu\n", count, rounds, mismatches);
+    printf("%-28s %10.3f ms total %8.2f us/pid\n", "stdio (stat+status)",
+           t_stdio * 1e3, parsed_stdio ? t_stdio * 1e6 / (double)parsed_stdio : 0.0);
+    printf("%-28s %10.3f ms total %8.2f us/pid\n", "open/pread (stat+statm)",
+           t_pread * 1e3, parsed_pread ? t_pread * 1e6 / (double)parsed_pread : 0.0);
+    if (t_pread > 0)
+        printf("speedup: %.2fx\n", t_stdio / t_pread);
+
+    free(pids);
+    return mismatches == 0 ? 0 : 1;
+}